@@ -8,7 +8,7 @@ where /q cl || (
 set warnings=/WX /W4 /wd4201 /wd4100 /wd4189 /wd4505 /wd4101 /wd4324 /wd4244
 set includes=/I ../my_lib/ /I ../external/raylib/
 set linkerFlags=/OUT:Main.exe /INCREMENTAL /CGTHREADS:6 /STACK:0x100000,0x100000 
-set linkerLibs=winmm.lib user32.lib shell32.lib gdi32.lib opengl32.lib
+set linkerLibs=winmm.lib user32.lib shell32.lib gdi32.lib opengl32.lib ws2_32.lib
 set compilerFlags=/std:c++20 /MP /arch:AVX2 /Oi /Ob3 /EHsc /fp:fast /fp:except- /nologo /GS- /Gs999999 /GR- /FC /Z7 
 
 if "%~1"=="-Debug" (
@@ -39,5 +39,10 @@ lib /OUT:%rayname%.lib rcore.obj raudio.obj rglfw.obj rmodels.obj rshapes.obj rt
 del /Q *.obj
 )
 
-cl.exe %compilerFlags% %warnings% %includes% ../source/Main.cpp /link %linkerFlags% %rayname%.lib %linkerLibs%
+cl.exe %compilerFlags% %warnings% %includes% ../source/Main.cpp ../source/Telemetry.cpp /link %linkerFlags% %rayname%.lib %linkerLibs%
+cl.exe %compilerFlags% %warnings% %includes% /LD /D ENV_BUILD_DLL ../source/Env.cpp /link /OUT:AsteroidEnv.dll
+cl.exe %compilerFlags% %warnings% ../source/EnvBench.cpp /link /OUT:EnvBench.exe AsteroidEnv.lib
+cl.exe %compilerFlags% %warnings% %includes% ../source/NarrowphaseBench.cpp /link /OUT:NarrowphaseBench.exe
+cl.exe %compilerFlags% %warnings% %includes% ../source/RenderCommandsCheck.cpp /link /OUT:RenderCommandsCheck.exe
+cl.exe %compilerFlags% %warnings% ../source/TelemetryReader.cpp ../source/Telemetry.cpp /link /OUT:TelemetryReader.exe ws2_32.lib
 popd
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+// Frame capture to a GIF or a raw RGBA dump on an encoder thread of its own.
+// The render thread copies each finished readback into one of a few buffers
+// allocated up front and queues it; the encoder writes it out and hands the
+// buffer back. When every buffer is still taken the frame is dropped, so a
+// slow encoder costs frames of the recording, never frame time.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <external/msf_gif.h> // compiled into raylib (SUPPORT_GIF_RECORDING)
+
+#include "Threading.h"
+
+enum class CaptureFormat : uint8_t { GIF, RAW };
+
+class CaptureEncoder {
+public:
+	~CaptureEncoder() {
+		Stop();
+	}
+
+	// `.gif` gets a GIF, any other name raw RGBA frames top row first.
+	// `fps` is the intended rate, it times the last GIF frame and goes in the report.
+	bool Start(const char* path, int w, int h, int fps) {
+		const char* ext = std::strrchr(path, '.');
+		format = (ext && (std::strcmp(ext, ".gif") == 0 || std::strcmp(ext, ".GIF") == 0)) ? CaptureFormat::GIF : CaptureFormat::RAW;
+		file = std::fopen(path, "wb");
+		if (!file) return false;
+		filePath = path;
+		width = w;
+		height = h;
+		rate = std::max(1, fps);
+		frameBytes = static_cast<size_t>(w) * h * 4;
+		pixels.assign(frameBytes * C_SLOTS, 0);
+		for (uint8_t s = 0; s < C_SLOTS; ++s) freeSlots.Push(s);
+		if (format == CaptureFormat::GIF) msf_gif_begin_to_file(&gif, w, h, WriteToFile, file);
+		worker = std::thread([this]() { Loop(); });
+		return true;
+	}
+
+	// Writes out what is queued, closes the file
+	void Stop() {
+		if (!worker.joinable()) return;
+		quit.store(true, std::memory_order_release);
+		worker.join();
+		if (format == CaptureFormat::GIF) msf_gif_end_to_file(&gif);
+		std::fclose(file);
+		file = nullptr;
+	}
+
+	bool Active() const {
+		return file != nullptr;
+	}
+
+	int Width() const {
+		return width;
+	}
+
+	int Height() const {
+		return height;
+	}
+
+	// Render thread: buffer for the next frame, rows bottom-up as glReadPixels
+	// writes them. nullptr means the encoder is behind and the frame is dropped.
+	uint8_t* BeginFrame() {
+		if (!freeSlots.Pop(open)) {
+			++dropped;
+			return nullptr;
+		}
+		return pixels.data() + open * frameBytes;
+	}
+
+	// Render thread: queues the buffer from BeginFrame, taken at `time` seconds
+	void EndFrame(double time) {
+		queuedFrames.Push({ time, open }); // never fails, no more frames are out than there are slots
+		++queued;
+	}
+
+	long long Queued() const {
+		return queued;
+	}
+
+	long long Dropped() const {
+		return dropped;
+	}
+
+	// After Stop
+	void Print(std::FILE* out) const {
+		std::fprintf(out, "capture: %lld frames %dx%d written to %s, %lld dropped by a busy encoder; encode avg %.1f ms, max %.1f ms\n",
+			written, width, height, filePath, dropped, written ? encodeMsSum / written : 0.0, encodeMsMax);
+		if (format == CaptureFormat::RAW) {
+			std::fprintf(out, "capture: raw RGBA, e.g. ffmpeg -f rawvideo -pixel_format rgba -video_size %dx%d -framerate %d -i %s capture.mp4\n",
+				width, height, rate, filePath);
+		}
+	}
+
+private:
+	struct Frame {
+		double time;
+		uint8_t slot;
+	};
+
+	static size_t WriteToFile(const void* data, size_t size, size_t count, void* stream) {
+		return std::fwrite(data, size, count, static_cast<std::FILE*>(stream));
+	}
+
+	void Loop() {
+		Frame f;
+		for (;;) {
+			if (queuedFrames.Pop(f)) {
+				Encode(f);
+				continue;
+			}
+			if (quit.load(std::memory_order_acquire)) {
+				while (queuedFrames.Pop(f)) Encode(f);
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		// The last GIF frame has no successor to time it, it gets one nominal frame
+		if (hasPending) Write(pending, centiseconds + static_cast<int>(std::lround(100.0 / rate)));
+	}
+
+	// A GIF frame lasts until the next one starts, so each is written when its
+	// successor arrives; delays follow the capture times, dropped frames included
+	void Encode(const Frame& f) {
+		if (format == CaptureFormat::RAW) {
+			Write(f, 0);
+			return;
+		}
+		if (!hasPending) {
+			firstTime = f.time;
+			hasPending = true;
+		}
+		else {
+			Write(pending, static_cast<int>(std::lround((f.time - firstTime) * 100.0)));
+		}
+		pending = f;
+	}
+
+	// `endCentiseconds` is when the frame stops showing, counted from the first frame
+	void Write(const Frame& f, int endCentiseconds) {
+		auto start = std::chrono::steady_clock::now();
+		const uint8_t* rows = pixels.data() + f.slot * frameBytes;
+		int pitch = width * 4;
+		if (format == CaptureFormat::GIF) {
+			int delay = std::max(1, endCentiseconds - centiseconds);
+			centiseconds += delay;
+			// Negative pitch flips the bottom-up rows
+			msf_gif_frame_to_file(&gif, const_cast<uint8_t*>(rows), delay, C_GIF_BIT_DEPTH, -pitch);
+		}
+		else {
+			for (int y = height - 1; y >= 0; --y) std::fwrite(rows + static_cast<size_t>(y) * pitch, 1, pitch, file);
+		}
+		freeSlots.Push(f.slot);
+
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+		encodeMsSum += ms.count();
+		encodeMsMax = std::max(encodeMsMax, ms.count());
+		++written;
+	}
+
+	// One held back by the GIF timing, one being written, the rest absorb a slow frame
+	static constexpr uint8_t C_SLOTS = 4;
+	static constexpr int C_GIF_BIT_DEPTH = 16;
+
+	CaptureFormat format = CaptureFormat::GIF;
+	std::FILE* file = nullptr;
+	const char* filePath = "";
+	int width = 0;
+	int height = 0;
+	int rate = 30;
+	size_t frameBytes = 0;
+	std::vector<uint8_t> pixels; // C_SLOTS frames
+
+	// Render thread
+	uint8_t open = 0;
+	long long queued = 0;
+	long long dropped = 0;
+
+	// Encoder thread
+	MsfGifState gif{};
+	Frame pending{};
+	bool hasPending = false;
+	double firstTime = 0.0;
+	int centiseconds = 0;
+	long long written = 0;
+	double encodeMsSum = 0.0;
+	double encodeMsMax = 0.0;
+
+	SpscQueue<Frame, C_SLOTS> queuedFrames; // render thread -> encoder
+	SpscQueue<uint8_t, C_SLOTS> freeSlots;  // encoder -> render thread
+	std::atomic<bool> quit{ false };
+	std::thread worker;
+};
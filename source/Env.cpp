@@ -0,0 +1,322 @@
+#include "Env.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Zones and counters go to one process-wide profiler, workers must not touch it
+#define PROFILER_DISABLED
+#include "Simulation.h"
+
+// --- ARENA ---
+// A one-screen-and-a-bit world: every chunk stays active around the player, so
+// Step skips the chunk streaming of the big map and instances stay small.
+static SimConfig ArenaConfig() {
+	SimConfig cfg;
+	cfg.chunksX = 3;
+	cfg.chunksY = 2;
+	cfg.chunkSize = 1024.f;
+	cfg.worldAsteroids = 40;
+	cfg.maxAsteroids = 64;
+	cfg.maxProjectiles = 512;
+	cfg.maxCollisionEvents = 1024;
+	cfg.maxGunships = 0; // observations list asteroids only
+	cfg.safeRadius = 500.f;
+	return cfg;
+}
+
+static constexpr int C_VIEW_W = 2560;
+static constexpr int C_VIEW_H = 1400;
+static constexpr float C_DT = 1.f / 60.f;
+static constexpr float C_REWARD_PER_POINT = 0.01f;
+static constexpr float C_DEATH_REWARD = -1.f;
+
+// --- INSTANCES ---
+struct EnvInstance {
+	std::unique_ptr<Simulation> sim;
+	Utils::Rng episodeSeeds{ 0 }; // the next episode's seed after an automatic reset
+	int steps = 0;
+	int lastScore = 0;
+};
+
+// One per thread. The caller's thread runs shard 0, the rest wait for a new
+// generation. Padded to a cache line so the shards never write to the same one.
+struct alignas(64) EnvWorker {
+	size_t begin = 0;
+	size_t end = 0;
+	std::vector<std::pair<float, uint32_t>> nearest; // ENV_OBS_ENTITIES scratch
+	std::thread thread;
+};
+
+enum class EnvJob {
+	CREATE,
+	RESET,
+	STEP,
+	QUIT,
+};
+
+struct Env {
+	EnvConfig config{};
+	SimConfig arena;
+	int32_t obsSize = 0;
+	std::vector<EnvInstance> instances;
+	std::vector<EnvWorker> workers;
+
+	// Arguments of the current job, published by the generation bump
+	EnvJob job = EnvJob::CREATE;
+	const uint64_t* seeds = nullptr;
+	const EnvAction* actions = nullptr;
+	float* obs = nullptr;
+	float* rewards = nullptr;
+	uint8_t* dones = nullptr;
+
+	alignas(64) std::atomic<uint32_t> generation{ 0 };
+	alignas(64) std::atomic<int> pending{ 0 };
+};
+
+// --- OBSERVATIONS ---
+static void WritePlayer(const Env& env, const EnvInstance& inst, float* out) {
+	const Simulation& sim = *inst.sim;
+	const PlayerShip& p = sim.GetPlayer();
+	Vector2 pos = p.GetPosition();
+	out[0] = pos.x / sim.WorldWidth();
+	out[1] = pos.y / sim.WorldHeight();
+	out[2] = std::max(p.GetHP(), 0) / 100.f;
+	out[3] = p.IsAlive() ? 1.f : 0.f;
+	out[4] = p.GetOverheatPercent();
+	out[5] = p.IsOverheated() ? 1.f : 0.f;
+	out[6] = static_cast<float>(sim.GetWeapon());
+	out[7] = static_cast<float>(inst.steps) / env.config.maxSteps;
+}
+
+// The maxEntities nearest asteroids, nearest first. Ties go to the lower index
+// so the list is the same on every run.
+static void WriteEntities(const Env& env, const EnvInstance& inst, EnvWorker& w, float* out) {
+	const std::vector<Asteroid>& asteroids = inst.sim->GetAsteroids();
+	Vector2 origin = inst.sim->GetPlayer().GetPosition();
+	const float inv = 1.f / C_VIEW_H;
+
+	w.nearest.clear();
+	for (uint32_t i = 0; i < asteroids.size(); ++i) {
+		w.nearest.push_back({ Vector2DistanceSqr(origin, asteroids[i].GetPosition()), i });
+	}
+	size_t k = std::min(w.nearest.size(), static_cast<size_t>(env.config.maxEntities));
+	std::partial_sort(w.nearest.begin(), w.nearest.begin() + k, w.nearest.end());
+
+	for (size_t n = 0; n < k; ++n) {
+		const Asteroid& a = asteroids[w.nearest[n].second];
+		Vector2 pos = a.GetPosition();
+		Vector2 vel = a.GetVelocity();
+		float* e = out + n * ENV_ENTITY_FEATURES;
+		e[0] = (pos.x - origin.x) * inv;
+		e[1] = (pos.y - origin.y) * inv;
+		e[2] = vel.x * inv;
+		e[3] = vel.y * inv;
+		e[4] = a.GetRadius() * inv;
+	}
+	std::fill(out + k * ENV_ENTITY_FEATURES, out + env.config.maxEntities * ENV_ENTITY_FEATURES, 0.f);
+}
+
+// 1 where an asteroid's bounding box touches the cell, 0 elsewhere
+static void WriteGrid(const Env& env, const EnvInstance& inst, float* out) {
+	const int g = env.config.gridSize;
+	const float cell = env.config.gridCellSize;
+	Vector2 p = inst.sim->GetPlayer().GetPosition();
+	float left = p.x - g * cell * 0.5f;
+	float top = p.y - g * cell * 0.5f;
+
+	std::fill(out, out + g * g, 0.f);
+	for (const Asteroid& a : inst.sim->GetAsteroids()) {
+		Vector2 pos = a.GetPosition();
+		float r = a.GetRadius();
+		int x0 = std::max(static_cast<int>(std::floor((pos.x - r - left) / cell)), 0);
+		int x1 = std::min(static_cast<int>(std::floor((pos.x + r - left) / cell)), g - 1);
+		int y0 = std::max(static_cast<int>(std::floor((pos.y - r - top) / cell)), 0);
+		int y1 = std::min(static_cast<int>(std::floor((pos.y + r - top) / cell)), g - 1);
+		for (int y = y0; y <= y1; ++y)
+			for (int x = x0; x <= x1; ++x)
+				out[y * g + x] = 1.f;
+	}
+}
+
+static void WriteObservation(const Env& env, const EnvInstance& inst, EnvWorker& w, float* out) {
+	WritePlayer(env, inst, out);
+	if (env.config.obsMode == ENV_OBS_GRID) WriteGrid(env, inst, out + ENV_PLAYER_FEATURES);
+	else WriteEntities(env, inst, w, out + ENV_PLAYER_FEATURES);
+}
+
+// --- STEPPING ---
+// Reset parks the whole population, one idle tick wakes the arena so the first
+// observation already shows the asteroids.
+static void StartEpisode(EnvInstance& inst) {
+	inst.sim->Reset(inst.episodeSeeds.Next());
+	inst.sim->Step(C_DT, PlayerInput{});
+	inst.steps = 0;
+	inst.lastScore = 0;
+}
+
+static void ResetInstance(EnvInstance& inst, uint64_t seed) {
+	inst.episodeSeeds = Utils::Rng(seed);
+	StartEpisode(inst);
+}
+
+static void StepInstance(const Env& env, EnvInstance& inst, const EnvAction& action, float& reward, uint8_t& done) {
+	Simulation& sim = *inst.sim;
+	PlayerInput input;
+	input.move = { Clamp(action.moveX, -1.f, 1.f), Clamp(action.moveY, -1.f, 1.f) };
+	input.fire = action.fire != 0;
+	input.skill = action.skill != 0;
+
+	for (int f = 0; f < env.config.frameSkip && sim.GetPlayer().IsAlive(); ++f) {
+		// A switch is a key press, not a held key
+		input.switchWeapon = (f == 0) && action.switchWeapon != 0;
+		sim.Step(C_DT, input);
+	}
+	++inst.steps;
+
+	int score = sim.GetScore();
+	reward = (score - inst.lastScore) * C_REWARD_PER_POINT;
+	inst.lastScore = score;
+	bool dead = !sim.GetPlayer().IsAlive();
+	if (dead) reward += C_DEATH_REWARD;
+
+	done = (dead || inst.steps >= env.config.maxSteps) ? 1 : 0;
+	if (done) StartEpisode(inst);
+}
+
+static void RunShard(Env& env, EnvWorker& w) {
+	for (size_t i = w.begin; i < w.end; ++i) {
+		EnvInstance& inst = env.instances[i];
+		float* obs = env.obs ? env.obs + i * env.obsSize : nullptr;
+		switch (env.job) {
+		case EnvJob::CREATE:
+			// Built on the thread that steps it, so its memory is local to that core
+			inst.sim = std::make_unique<Simulation>(C_VIEW_W, C_VIEW_H, 0, env.arena);
+			break;
+		case EnvJob::RESET:
+			ResetInstance(inst, env.seeds[i]);
+			WriteObservation(env, inst, w, obs);
+			break;
+		case EnvJob::STEP:
+			StepInstance(env, inst, env.actions[i], env.rewards[i], env.dones[i]);
+			WriteObservation(env, inst, w, obs);
+			break;
+		case EnvJob::QUIT:
+			break;
+		}
+	}
+}
+
+static void WorkerLoop(Env* env, EnvWorker* w) {
+	uint32_t seen = 0;
+	for (;;) {
+		env->generation.wait(seen, std::memory_order_acquire);
+		seen = env->generation.load(std::memory_order_acquire);
+		if (env->job == EnvJob::QUIT) return;
+		RunShard(*env, *w);
+		if (env->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) env->pending.notify_one();
+	}
+}
+
+// Publishes the job to every worker, runs shard 0 here and waits for the rest
+static void RunJob(Env& env, EnvJob job) {
+	env.job = job;
+	env.pending.store(static_cast<int>(env.workers.size()) - 1, std::memory_order_relaxed);
+	env.generation.fetch_add(1, std::memory_order_release);
+	env.generation.notify_all();
+	if (job == EnvJob::QUIT) return;
+
+	RunShard(env, env.workers[0]);
+	for (int left = env.pending.load(std::memory_order_acquire); left != 0; left = env.pending.load(std::memory_order_acquire)) {
+		env.pending.wait(left, std::memory_order_acquire);
+	}
+}
+
+// --- C API ---
+extern "C" {
+
+ENV_API EnvConfig env_default_config(void) {
+	EnvConfig cfg;
+	cfg.numEnvs = 256;
+	cfg.numThreads = 0;
+	cfg.obsMode = ENV_OBS_ENTITIES;
+	cfg.maxEntities = 16;
+	cfg.gridSize = 16;
+	cfg.gridCellSize = 128.f;
+	cfg.frameSkip = 4;
+	cfg.maxSteps = 4500;
+	return cfg;
+}
+
+ENV_API Env* env_create(const EnvConfig* config) {
+	if (!config || config->numEnvs <= 0 || config->frameSkip <= 0 || config->maxSteps <= 0) return nullptr;
+	if (config->obsMode == ENV_OBS_ENTITIES && config->maxEntities <= 0) return nullptr;
+	if (config->obsMode == ENV_OBS_GRID && (config->gridSize <= 0 || config->gridCellSize <= 0.f)) return nullptr;
+	if (config->obsMode != ENV_OBS_ENTITIES && config->obsMode != ENV_OBS_GRID) return nullptr;
+
+	Env* env = new (std::nothrow) Env;
+	if (!env) return nullptr;
+	env->config = *config;
+	env->arena = ArenaConfig();
+	env->obsSize = ENV_PLAYER_FEATURES + (config->obsMode == ENV_OBS_GRID
+		? config->gridSize * config->gridSize
+		: config->maxEntities * ENV_ENTITY_FEATURES);
+	env->instances.resize(static_cast<size_t>(config->numEnvs));
+
+	int threads = config->numThreads > 0 ? config->numThreads : static_cast<int>(std::thread::hardware_concurrency());
+	threads = std::clamp(threads, 1, config->numEnvs);
+	env->workers = std::vector<EnvWorker>(static_cast<size_t>(threads));
+
+	// Contiguous shards, the first numEnvs % threads get one extra
+	size_t base = config->numEnvs / threads;
+	size_t extra = config->numEnvs % threads;
+	size_t next = 0;
+	for (size_t t = 0; t < env->workers.size(); ++t) {
+		EnvWorker& w = env->workers[t];
+		w.begin = next;
+		next += base + (t < extra ? 1 : 0);
+		w.end = next;
+		w.nearest.reserve(env->arena.ActiveCapacity());
+	}
+	for (size_t t = 1; t < env->workers.size(); ++t) {
+		env->workers[t].thread = std::thread(WorkerLoop, env, &env->workers[t]);
+	}
+
+	RunJob(*env, EnvJob::CREATE);
+	return env;
+}
+
+ENV_API void env_destroy(Env* env) {
+	if (!env) return;
+	RunJob(*env, EnvJob::QUIT);
+	for (size_t t = 1; t < env->workers.size(); ++t) {
+		env->workers[t].thread.join();
+	}
+	delete env;
+}
+
+ENV_API int32_t env_observation_size(const Env* env) {
+	return env->obsSize;
+}
+
+ENV_API void env_reset(Env* env, const uint64_t* seeds, float* obs) {
+	env->seeds = seeds;
+	env->obs = obs;
+	RunJob(*env, EnvJob::RESET);
+}
+
+ENV_API void env_step(Env* env, const EnvAction* actions, float* obs, float* rewards, uint8_t* dones) {
+	env->actions = actions;
+	env->obs = obs;
+	env->rewards = rewards;
+	env->dones = dones;
+	RunJob(*env, EnvJob::STEP);
+}
+
+}
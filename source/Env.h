@@ -0,0 +1,81 @@
+#pragma once
+// Batch environment - many headless games stepped together for training agents.
+// Plain C interface so it loads from Python (ctypes, cffi) as easily as from C++.
+//
+//   EnvConfig cfg = env_default_config();
+//   cfg.numEnvs = 1024;
+//   Env* env = env_create(&cfg);
+//   float* obs = ... numEnvs * env_observation_size(env) floats ...
+//   env_reset(env, seeds, obs);
+//   for (;;) env_step(env, actions, obs, rewards, dones);
+//
+// Every instance owns its Simulation and rng, instances are split into
+// contiguous shards and each shard is stepped by one worker thread. Observations,
+// rewards and dones are written straight into the caller's arrays - the library
+// never hands out memory of its own. A finished instance resets itself from its
+// next seed and the observation written for it is the first one of the new episode.
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(ENV_BUILD_DLL)
+#define ENV_API __declspec(dllexport)
+#else
+#define ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum EnvObservationMode {
+	ENV_OBS_ENTITIES = 0, // the nearest asteroids as a fixed-size list
+	ENV_OBS_GRID = 1,     // asteroid occupancy around the player
+};
+
+// Player block at the start of every observation:
+// x, y (0..1 of the arena), hp (0..1), alive, overheat (0..1), overheated, weapon, episode progress (0..1)
+#define ENV_PLAYER_FEATURES 8
+// Per listed asteroid: dx, dy, vx, vy, radius - divided by the view height and
+// relative to the player. Unused slots are all zeros.
+#define ENV_ENTITY_FEATURES 5
+
+typedef struct EnvConfig {
+	int32_t numEnvs;
+	int32_t numThreads;   // 0 = one per hardware thread
+	int32_t obsMode;      // EnvObservationMode
+	int32_t maxEntities;  // ENV_OBS_ENTITIES - asteroids listed, nearest first
+	int32_t gridSize;     // ENV_OBS_GRID - gridSize x gridSize cells centered on the player
+	float gridCellSize;   // ENV_OBS_GRID - cell size in world pixels
+	int32_t frameSkip;    // simulation ticks per env_step, the action is held for all of them
+	int32_t maxSteps;     // env_step calls before an episode is cut off
+} EnvConfig;
+
+typedef struct EnvAction {
+	float moveX;          // -1..1
+	float moveY;          // -1..1
+	int32_t fire;
+	int32_t skill;
+	int32_t switchWeapon;
+} EnvAction;
+
+typedef struct Env Env;
+
+ENV_API EnvConfig env_default_config(void);
+
+// Returns NULL when the config is out of range
+ENV_API Env* env_create(const EnvConfig* config);
+ENV_API void env_destroy(Env* env);
+
+// Floats per instance in the observation arrays
+ENV_API int32_t env_observation_size(const Env* env);
+
+// seeds[numEnvs], obs[numEnvs * env_observation_size]
+ENV_API void env_reset(Env* env, const uint64_t* seeds, float* obs);
+
+// actions[numEnvs], obs[numEnvs * env_observation_size], rewards[numEnvs], dones[numEnvs].
+// Reward is 0.01 per score point, -1 on death.
+ENV_API void env_step(Env* env, const EnvAction* actions, float* obs, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,618 +5,1250 @@
 #include <cstdlib>
 #include <cmath>
 #include <ctime>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <array>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <cfloat>
+#include <cstddef>
+#include <thread>
 
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
+#include <external/glad.h> // the GL functions raylib already loaded, for the capture readback
+
+#include "Capture.h"
+#include "Memory.h"
+#include "Profiler.h"
+#include "Simulation.h"
+#include "Telemetry.h"
+#include "Threading.h"
+
+// --- MEMORY ---
+// Every allocation of the game goes through the counters in Memory.h
+void* operator new(std::size_t size) {
+	return Memory::Allocate(size);
+}
 
-// --- UTILS ---
-namespace Utils {
-	inline static float RandomFloat(float min, float max) {
-		return min + static_cast<float>(rand()) / RAND_MAX * (max - min);
-	}
+void* operator new[](std::size_t size) {
+	return Memory::Allocate(size);
 }
 
-// --- TRANSFORM, PHYSICS, LIFETIME, RENDERABLE ---
-struct TransformA {
-	Vector2 position{};
-	float rotation{};
-};
+void operator delete(void* p) noexcept {
+	Memory::Free(p);
+}
 
-struct Physics {
-	Vector2 velocity{};
-	float rotationSpeed{};
-};
+void operator delete[](void* p) noexcept {
+	Memory::Free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	Memory::Free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	Memory::Free(p);
+}
 
-struct Renderable {
-	enum Size { SMALL = 1, MEDIUM = 2, LARGE = 4 } size = SMALL;
+// --- TELEMETRY ---
+// Publishes a TelemetryPacket about once per second over the local UDP socket
+// (see Telemetry.h, read it with TelemetryReader). Per-frame work is a handful
+// of additions; the send is non-blocking and a missing reader costs nothing.
+// The window thread reports its frames, the simulation thread its ticks, phases
+// and counts, and publishes both once its ticks cover the sample window.
+struct TickStats {
+	float dt;     // since the previous tick
+	float workMs; // spent in this tick
+	uint32_t asteroids;
+	uint32_t maxAsteroids;
+	uint32_t projectiles;
+	uint32_t maxProjectiles;
+	uint64_t spawns;
+	uint64_t collisionTests;
+	uint64_t maskRejected;
 };
 
-// --- RENDERER ---
-class Renderer {
+class Telemetry {
 public:
-	static Renderer& Instance() {
-		static Renderer inst;
+	static Telemetry& Instance() {
+		static Telemetry inst;
 		return inst;
 	}
 
-	void Init(int w, int h, const char* title) {
-		InitWindow(w, h, title);
-		SetTargetFPS(60);
-		screenW = w;
-		screenH = h;
-		backgroundTexture = LoadTexture("background.png"); 
+	void Init() {
+		socket.OpenSender();
+		lastAllocCount = Memory::allocCount.load(std::memory_order_relaxed);
+		lastAllocBytes = Memory::allocBytes.load(std::memory_order_relaxed);
 	}
 
-	void Begin() {
-		BeginDrawing();
-		DrawTextureEx(
-			backgroundTexture,
-			{ 0, 0 },
-			0.0f,
-			std::max(
-				(float)Width() / backgroundTexture.width,
-				(float)Height() / backgroundTexture.height
-			),
-			WHITE
-		);
+	// Window thread, once per presented frame. A frame that ends while a sample
+	// goes out may have its count and its time land in neighbouring samples.
+	void EndFrame(float dt, int drawCalls) {
+		if (!socket.IsOpen()) return;
+
+		uint32_t us = static_cast<uint32_t>(dt * 1e6f);
+		frames.fetch_add(1, std::memory_order_relaxed);
+		frameUs.fetch_add(us, std::memory_order_relaxed);
+		frameDrawCalls.fetch_add(static_cast<uint64_t>(drawCalls), std::memory_order_relaxed);
+		uint32_t max = maxFrameUs.load(std::memory_order_relaxed);
+		while (us > max && !maxFrameUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
 	}
 
-	void End() {
-		EndDrawing();
-	}
+	// Simulation thread, after all profiler zones of the tick have closed
+	void EndTick(const TickStats& t) {
+		if (!socket.IsOpen()) return;
+
+		++ticks;
+		window += t.dt;
+		tickMs += t.workMs;
+		maxTickMs = std::max(maxTickMs, t.workMs);
+		spawns += t.spawns;
+		collisionTests += t.collisionTests;
+		maskRejected += t.maskRejected;
+
+		Profiler::Instance().ForEachZone([this](const char* name, double ms) {
+			int i = 0;
+			while (i < phaseCount && phaseNames[i] != name) ++i;
+			if (i == phaseCount) {
+				if (phaseCount == TELEMETRY_MAX_PHASES) return;
+				phaseNames[phaseCount++] = name;
+			}
+			phaseMs[i] += ms;
+		});
 
-	void DrawPoly(const Vector2& pos, int sides, float radius, float rot) {
-		DrawPolyLines(pos, sides, radius, rot, WHITE);
+		if (window >= PERIOD) Publish(t);
 	}
 
-	int Width() const {
-		return screenW;
-	}
+private:
+	Telemetry() = default;
+
+	void Publish(const TickStats& t) {
+		TelemetryPacket p{};
+		p.magic = TELEMETRY_MAGIC;
+		p.version = TELEMETRY_VERSION;
+		p.sequence = sequence++;
+		p.windowSec = window;
+
+		uint32_t frameCount = frames.exchange(0, std::memory_order_relaxed);
+		uint64_t frameTotalUs = frameUs.exchange(0, std::memory_order_relaxed);
+		p.frames = frameCount;
+		p.fps = frameCount / window;
+		p.avgFrameMs = frameCount ? static_cast<float>(frameTotalUs * 1e-3 / frameCount) : 0.f;
+		p.maxFrameMs = maxFrameUs.exchange(0, std::memory_order_relaxed) * 1e-3f;
+		p.drawCalls = frameDrawCalls.exchange(0, std::memory_order_relaxed);
+
+		p.ticks = ticks;
+		p.tickRate = ticks / window;
+		p.avgTickMs = static_cast<float>(tickMs / ticks);
+		p.maxTickMs = maxTickMs;
+
+		p.asteroids = t.asteroids;
+		p.maxAsteroids = t.maxAsteroids;
+		p.projectiles = t.projectiles;
+		p.maxProjectiles = t.maxProjectiles;
+
+		p.spawns = spawns;
+		p.collisionTests = collisionTests;
+		p.maskRejected = maskRejected;
+
+		uint64_t allocCount = Memory::allocCount.load(std::memory_order_relaxed);
+		uint64_t allocBytes = Memory::allocBytes.load(std::memory_order_relaxed);
+		p.heapAllocs = allocCount - lastAllocCount;
+		p.heapBytes = allocBytes - lastAllocBytes;
+		lastAllocCount = allocCount;
+		lastAllocBytes = allocBytes;
+
+		p.phaseCount = static_cast<uint32_t>(phaseCount);
+		for (int i = 0; i < phaseCount; ++i) {
+			std::snprintf(p.phases[i].name, TELEMETRY_PHASE_NAME, "%s", phaseNames[i]);
+			p.phases[i].avgMs = static_cast<float>(phaseMs[i] / ticks);
+		}
 
-	int Height() const {
-		return screenH;
-	}
+		socket.Send(&p, sizeof(p));
 
-private:
-	Renderer() = default;
+		ticks = 0;
+		window = 0.f;
+		tickMs = 0.0;
+		maxTickMs = 0.f;
+		spawns = collisionTests = maskRejected = 0;
+		phaseMs.fill(0.0);
+	}
 
-	int screenW{};
-	int screenH{};
-	Texture2D backgroundTexture;
+	static constexpr float PERIOD = 1.f;
+
+	TelemetrySocket socket;
+
+	// Window thread adds, the simulation thread takes them when it publishes
+	std::atomic<uint32_t> frames{ 0 };
+	std::atomic<uint64_t> frameUs{ 0 };
+	std::atomic<uint32_t> maxFrameUs{ 0 };
+	std::atomic<uint64_t> frameDrawCalls{ 0 };
+
+	// Simulation thread
+	uint32_t sequence = 0;
+	uint32_t ticks = 0;
+	float window = 0.f;
+	double tickMs = 0.0;
+	float maxTickMs = 0.f;
+	uint64_t spawns = 0;
+	uint64_t collisionTests = 0;
+	uint64_t maskRejected = 0;
+	uint64_t lastAllocCount = 0;
+	uint64_t lastAllocBytes = 0;
+
+	std::array<const char*, TELEMETRY_MAX_PHASES> phaseNames{};
+	std::array<double, TELEMETRY_MAX_PHASES> phaseMs{};
+	int phaseCount = 0;
 };
 
-// --- ASTEROID HIERARCHY ---
-
-class Asteroid {
+// --- RESOLUTION SCALING ---
+// Picks the scene's render scale from measured render time. Steps down after a
+// few frames over budget, steps back up only after a long stretch with clear
+// headroom, so it settles instead of oscillating between two scales.
+class ResolutionScaler {
 public:
-	Asteroid(int screenW, int screenH) {
-		init(screenW, screenH);
+	static constexpr float MIN_SCALE = 0.5f;
+	static constexpr float STEP = 0.1f;
+	static constexpr int HISTORY = 240; // frames
+
+	void Update(double renderMs, double budgetMs) {
+		if (fixedScale > 0.f) {
+			scale = fixedScale;
+		}
+		else {
+			if (renderMs > budgetMs * OVER_BUDGET) {
+				++framesOver;
+				framesUnder = 0;
+			}
+			else if (renderMs < budgetMs * HEADROOM) {
+				++framesUnder;
+				framesOver = 0;
+			}
+			else {
+				framesOver = 0;
+				framesUnder = 0;
+			}
+
+			if (framesOver >= DOWN_FRAMES && scale > MIN_SCALE) {
+				scale = std::max(MIN_SCALE, scale - STEP);
+				framesOver = 0;
+			}
+			if (framesUnder >= UP_FRAMES && scale < 1.f) {
+				scale = std::min(1.f, scale + STEP);
+				framesUnder = 0;
+			}
+		}
+		history[historyHead] = scale;
+		historyHead = (historyHead + 1) % HISTORY;
+		historyCount = std::min(historyCount + 1, HISTORY);
 	}
-	virtual ~Asteroid() = default;
 
-	virtual bool Update(float dt) {
-		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-		transform.rotation += physics.rotationSpeed * dt;
-		if (transform.position.x < -GetRadius() || transform.position.x > Renderer::Instance().Width() + GetRadius() ||
-			transform.position.y < -GetRadius() || transform.position.y > Renderer::Instance().Height() + GetRadius())
-			return false;
-		return true;
+	// 0 lets the measured render time decide
+	void SetFixed(float s) {
+		fixedScale = (s > 0.f) ? Clamp(s, MIN_SCALE, 1.f) : 0.f;
+		framesOver = 0;
+		framesUnder = 0;
 	}
-	virtual void Draw() const = 0;
 
-	Vector2 GetPosition() const {
-		return transform.position;
+	float GetFixed() const {
+		return fixedScale;
 	}
 
-	float constexpr GetRadius() const {
-		return 16.f * (float)render.size;
+	float Scale() const {
+		return scale;
 	}
 
-	int GetDamage() const {
-		return baseDamage * static_cast<int>(render.size);
+	// Calls f(scale) for the recorded frames, oldest first
+	template <typename F>
+	void ForEachHistory(F&& f) const {
+		int start = (historyHead - historyCount + HISTORY) % HISTORY;
+		for (int i = 0; i < historyCount; ++i)
+			f(history[(start + i) % HISTORY]);
 	}
 
-	int GetSize() const {
-		return static_cast<int>(render.size);
+private:
+	static constexpr double OVER_BUDGET = 1.0;
+	static constexpr double HEADROOM = 0.6;
+	static constexpr int DOWN_FRAMES = 5;
+	static constexpr int UP_FRAMES = 90;
+
+	float scale = 1.f;
+	float fixedScale = 0.f;
+	int framesOver = 0;
+	int framesUnder = 0;
+
+	std::array<float, HISTORY> history{};
+	int historyHead = 0;
+	int historyCount = 0;
+};
+
+// --- FRAME CAPTURE ---
+// Reads finished frames back without waiting on the GPU. A captured frame is
+// blitted, scaled down, into a small render target and read into the next of a
+// ring of pixel buffer objects; the copy runs while the following frames are
+// drawn and is mapped only once its fence says it is done. Readbacks still in
+// flight when their buffer comes round again are dropped, like frames the
+// encoder has no room for, so capture never blocks the render thread.
+class FrameReadback {
+public:
+	~FrameReadback() {
+		Release();
 	}
 
-protected:
-	void init(int screenW, int screenH) {
-		// Choose size
-		render.size = static_cast<Renderable::Size>(1 << GetRandomValue(1, 2));
+	// Capture size is `scale` of the source frame
+	bool Start(const char* path, int srcW, int srcH, float scale, int fps) {
+		int w = std::max(2, static_cast<int>(srcW * scale)) & ~1;
+		int h = std::max(2, static_cast<int>(srcH * scale)) & ~1;
+		if (!encoder.Start(path, w, h, fps)) return false;
+		target = LoadRenderTexture(w, h);
+		frameBytes = static_cast<GLsizeiptr>(w) * h * 4;
+		for (Readback& r : ring) {
+			glGenBuffers(1, &r.pbo);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return true;
+	}
 
-		// Spawn at random edge
-		switch (GetRandomValue(0, 3)) {
-		case 0:
-			transform.position = { Utils::RandomFloat(0, screenW), -GetRadius() };
-			break;
-		case 1:
-			transform.position = { screenW + GetRadius(), Utils::RandomFloat(0, screenH) };
-			break;
-		case 2:
-			transform.position = { Utils::RandomFloat(0, screenW), screenH + GetRadius() };
-			break;
-		default:
-			transform.position = { -GetRadius(), Utils::RandomFloat(0, screenH) };
-			break;
+	bool Active() const {
+		return encoder.Active();
+	}
+
+	// Starts reading back the default framebuffer as it is now; call with the frame drawn, before EndDrawing
+	void Grab(int srcW, int srcH, double time) {
+		if (inFlight == C_RING) {
+			// The oldest readback is still not done, give up on it rather than wait
+			Readback& oldest = ring[(head + C_RING - inFlight) % C_RING];
+			glDeleteSync(oldest.fence);
+			oldest.fence = nullptr;
+			--inFlight;
+			++late;
 		}
 
-		// Aim towards center with jitter
-		float maxOff = fminf(screenW, screenH) * 0.2f;
-		float ang = Utils::RandomFloat(0, 2 * PI);
-		float rad = Utils::RandomFloat(0, maxOff);
-		Vector2 center = {
-										 screenW * 0.5f + cosf(ang) * rad,
-										 screenH * 0.5f + sinf(ang) * rad
-		};
+		rlDrawRenderBatchActive();
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.id);
+		glBlitFramebuffer(0, 0, srcW, srcH, 0, 0, encoder.Width(), encoder.Height(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+		Readback& r = ring[head];
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, target.id);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+		glReadPixels(0, 0, encoder.Width(), encoder.Height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		r.time = time;
+		head = (head + 1) % C_RING;
+		++inFlight;
+	}
+
+	// Hands every finished readback, oldest first, to the encoder. `wait` blocks
+	// until all are done, for the end of a recording only.
+	void Collect(bool wait = false) {
+		while (inFlight > 0) {
+			Readback& r = ring[(head + C_RING - inFlight) % C_RING];
+			GLenum status = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? C_FINISH_TIMEOUT_NS : 0);
+			if (status == GL_TIMEOUT_EXPIRED && !wait) return;
+			if (uint8_t* dst = encoder.BeginFrame()) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+				if (const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT)) {
+					std::memcpy(dst, src, static_cast<size_t>(frameBytes));
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				encoder.EndFrame(r.time);
+			}
+			glDeleteSync(r.fence);
+			r.fence = nullptr;
+			--inFlight;
+		}
+	}
 
-		Vector2 dir = Vector2Normalize(Vector2Subtract(center, transform.position));
-		physics.velocity = Vector2Scale(dir, Utils::RandomFloat(SPEED_MIN, SPEED_MAX));
-		physics.rotationSpeed = Utils::RandomFloat(ROT_MIN, ROT_MAX);
+	// Collects the last readbacks, lets the encoder finish the file and prints the totals
+	void Finish(std::FILE* report) {
+		if (!Active()) return;
+		Collect(true);
+		encoder.Stop();
+		encoder.Print(report);
+		std::fprintf(report, "capture: %lld readbacks dropped unfinished\n", late);
+		Release();
+	}
 
-		transform.rotation = Utils::RandomFloat(0, 360);
+	void PublishCounters() const {
+		Profiler::Instance().SetCounter("Capture frames", encoder.Queued());
+		Profiler::Instance().SetCounter("Capture dropped", encoder.Dropped() + late);
 	}
 
-	TransformA transform;
-	Physics    physics;
-	Renderable render;
+private:
+	struct Readback {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		double time = 0.0;
+	};
 
-	int baseDamage = 0;
-	static constexpr float LIFE = 10.f;
-	static constexpr float SPEED_MIN = 125.f;
-	static constexpr float SPEED_MAX = 250.f;
-	static constexpr float ROT_MIN = 50.f;
-	static constexpr float ROT_MAX = 240.f;
+	void Release() {
+		for (Readback& r : ring) {
+			if (r.fence) glDeleteSync(r.fence);
+			if (r.pbo) glDeleteBuffers(1, &r.pbo);
+			r = {};
+		}
+		if (target.id) UnloadRenderTexture(target);
+		target = {};
+		inFlight = 0;
+	}
+
+	static constexpr int C_RING = 3;
+	static constexpr GLuint64 C_FINISH_TIMEOUT_NS = 1'000'000'000;
 
-	Texture2D texture;
+	CaptureEncoder encoder;
+	RenderTexture2D target{};
+	std::array<Readback, C_RING> ring{};
+	GLsizeiptr frameBytes = 0;
+	int head = 0;     // next ring slot to read into
+	int inFlight = 0; // readbacks not collected yet, the ones just before head
+	long long late = 0;
 };
 
-class TriangleAsteroid : public Asteroid {
+// --- RENDERER ---
+// Owns the window and textures and submits recorded frames. The scene layers
+// are drawn into an offscreen target at ResolutionScaler::Scale() of the window
+// size and stretched to the window; HUD and DEBUG layers are drawn on top at
+// native resolution. The renderer also paces frames itself, so the time a frame
+// actually spends working is known, and feeds the frame capture when one runs.
+class Renderer {
 public:
-	TriangleAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 5;
-		texture = LoadTexture("asteroid_triangle.png");
-	}
-	~TriangleAsteroid() { UnloadTexture(texture); }
-	void Draw() const override {
-		float scale = GetRadius() * 2.0f / texture.width;
-		Vector2 center = transform.position;
-		Rectangle src = { 0, 0, (float)texture.width, (float)texture.height };
-		Rectangle dst = {
-			center.x,
-			center.y,
-			texture.width * scale,
-			texture.height * scale
-		};
-		Vector2 origin = { dst.width * 0.5f, dst.height * 0.5f };
-		DrawTexturePro(texture, src, dst, origin, transform.rotation, WHITE);
+	static Renderer& Instance() {
+		static Renderer inst;
+		return inst;
 	}
-};
-class SquareAsteroid : public Asteroid {
-public:
-	SquareAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 10;
-		texture = LoadTexture("asteroid_square.png");
-	}
-	~SquareAsteroid() { UnloadTexture(texture); }
-	void Draw() const override {
-		float scale = GetRadius() * 2.0f / texture.width;
-		Vector2 center = transform.position;
-		Rectangle src = { 0, 0, (float)texture.width, (float)texture.height };
-		Rectangle dst = {
-			center.x,
-			center.y,
-			texture.width * scale,
-			texture.height * scale
-		};
-		Vector2 origin = { dst.width * 0.5f, dst.height * 0.5f };
-		DrawTexturePro(texture, src, dst, origin, transform.rotation, WHITE);
+
+	// A hidden window still renders, headless capture draws into one
+	void Init(int w, int h, const char* title, bool hidden = false) {
+		if (hidden) SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		InitWindow(w, h, title);
+		SetTargetFPS(0); // paced in Submit
+		screenW = w;
+		screenH = h;
+		for (size_t i = 0; i < textures.size(); ++i) {
+			textures[i] = LoadTexture(TEXTURE_FILES[i]);
+		}
+		Texture2D& ship = textures[static_cast<size_t>(TextureSlot::PLAYER_SHIP)];
+		GenTextureMipmaps(&ship);                                                        // Generate GPU mipmaps for a texture
+		SetTextureFilter(ship, 2);
+		SetTextureWrap(textures[static_cast<size_t>(TextureSlot::BACKGROUND)], TEXTURE_WRAP_REPEAT); // tiled and scrolled with the camera
+
+		// Full size once; lower scales render into its top-left corner
+		sceneTarget = LoadRenderTexture(w, h);
+		SetTextureFilter(sceneTarget.texture, TEXTURE_FILTER_BILINEAR);
+		frameStart = GetTime();
 	}
-};
 
-class PentagonAsteroid : public Asteroid {
-public:
-	PentagonAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 15;
-		texture = LoadTexture("asteroid_pentagon.png");
-	}
-	~PentagonAsteroid() { UnloadTexture(texture); }
-	void Draw() const override {
-		float scale = GetRadius() * 2.0f / texture.width;
-		Vector2 center = transform.position;
-		Rectangle src = { 0, 0, (float)texture.width, (float)texture.height };
-		Rectangle dst = {
-			center.x,
-			center.y,
-			texture.width * scale,
-			texture.height * scale
-		};
-		Vector2 origin = { dst.width * 0.5f, dst.height * 0.5f };
-		DrawTexturePro(texture, src, dst, origin, transform.rotation, WHITE);
+	// 0 disables the limiter (benchmarks)
+	void SetFrameRateLimit(int fps) {
+		targetFps = fps;
 	}
-};
 
-class ChasingAsteroid : public Asteroid {
-public:
-	ChasingAsteroid(int w, int h, std::function<Vector2()> getPlayerPos, float manualOffsetDeg = 0.0f)
-		: Asteroid(w, h), getPlayerPosition(getPlayerPos), manualOffsetRad(manualOffsetDeg* (PI / 180.0f))
-	{
-		baseDamage = 20;
-		texture = LoadTexture("asteroid_chaser.png");
-	}
-	~ChasingAsteroid() { UnloadTexture(texture); }
-
-	bool Update(float dt) override {
-		// Kierunek do gracza
-		Vector2 playerPos = getPlayerPosition();
-		Vector2 dir = Vector2Normalize(Vector2Subtract(playerPos, transform.position));
-		float speed = 110.0f;
-		physics.velocity = Vector2Scale(dir, speed);
-
-		// Standardowy update pozycji
-		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-
-		// Usuwanie poza ekranem
-		if (transform.position.x < -GetRadius() || transform.position.x > Renderer::Instance().Width() + GetRadius() ||
-			transform.position.y < -GetRadius() || transform.position.y > Renderer::Instance().Height() + GetRadius())
-			return false;
-		return true;
+	// Records to `path` from now on (see FrameReadback), false when the file cannot be opened
+	bool StartCapture(const char* path, float scale, int fps) {
+		return capture.Start(path, GetRenderWidth(), GetRenderHeight(), scale, fps);
 	}
 
-	void Draw() const override {
-		// kąt do gracza
-		Vector2 playerPos = getPlayerPosition();
-		float angleToPlayer = atan2f(playerPos.y - transform.position.y, playerPos.x - transform.position.x);
+	bool IsCapturing() const {
+		return capture.Active();
+	}
 
-		
-		float finalAngle = angleToPlayer + manualOffsetRad;
+	// The next submitted frame is captured, stamped `time` seconds
+	void RequestCapture(double time) {
+		captureRequested = true;
+		captureTime = time;
+	}
 
-		float scale = GetRadius() * 2.0f / texture.width;
-		Vector2 center = transform.position;
-		Rectangle src = { 0, 0, (float)texture.width, (float)texture.height };
-		Rectangle dst = {
-			center.x,
-			center.y,
-			texture.width * scale,
-			texture.height * scale
-		};
-		Vector2 origin = { dst.width * 0.5f, dst.height * 0.5f };
-		DrawTexturePro(texture, src, dst, origin, finalAngle * (180.0f / PI), WHITE);
+	void FinishCapture(std::FILE* report) {
+		capture.Finish(report);
 	}
 
-private:
-	std::function<Vector2()> getPlayerPosition;
-	float manualOffsetRad;
-};
+	const Texture2D& GetTexture(TextureSlot slot) const {
+		return textures[static_cast<size_t>(slot)];
+	}
 
-// Shape selector
-enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, RANDOM = 0 };
-
-// Factory
-static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape shape, std::function<Vector2()> getPlayerPos = nullptr) {
-	switch (shape) {
-	case AsteroidShape::TRIANGLE:
-		return std::make_unique<TriangleAsteroid>(w, h);
-	case AsteroidShape::SQUARE:
-		return std::make_unique<SquareAsteroid>(w, h);
-	case AsteroidShape::PENTAGON:
-		return std::make_unique<PentagonAsteroid>(w, h);
-	case AsteroidShape::RANDOM: {
-		
-		int r = GetRandomValue(0, 9);
-		if (r < 1) // 0,1 -> chasing (20%)
-			return std::make_unique<ChasingAsteroid>(w, h, getPlayerPos, 45.0f);
-		else {
-			int type = GetRandomValue(0, 2);
-			switch (type) {
-			case 0: return std::make_unique<TriangleAsteroid>(w, h);
-			case 1: return std::make_unique<SquareAsteroid>(w, h);
-			default: return std::make_unique<PentagonAsteroid>(w, h);
-			}
-		}
+	ResolutionScaler& GetScaler() {
+		return scaler;
 	}
-	default:
-		return std::make_unique<ChasingAsteroid>(w, h, getPlayerPos, 45.0f);
+
+	const ResolutionScaler& GetScaler() const {
+		return scaler;
 	}
-}
 
-// --- PROJECTILE HIERARCHY ---
-enum class WeaponType { LASER, BULLET, COUNT };
-class Projectile {
-public:
-	Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt, Texture2D tex)
-		: texture(tex), hasTexture(true)
-	{
-		transform.position = pos;
-		physics.velocity = vel;
-		baseDamage = dmg;
-		type = wt;
-	}
-
-	Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt)
-		: hasTexture(false)
-	{
-		transform.position = pos;
-		physics.velocity = vel;
-		baseDamage = dmg;
-		type = wt;
-	}
-
-	bool Update(float dt) {
-		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-
-		if (transform.position.x < 0 ||
-			transform.position.x > Renderer::Instance().Width() ||
-			transform.position.y < 0 ||
-			transform.position.y > Renderer::Instance().Height())
-		{
-			return true;
-		}
-		return false;
+	// Background covering the screen, scrolling with the world view at parallax speed
+	void RecordBackground(RenderCommandBuffer& out, Rectangle view) const {
+		const Texture2D& background = GetTexture(TextureSlot::BACKGROUND);
+		float scale = std::max(
+			(float)Width() / background.width,
+			(float)Height() / background.height
+		);
+		Rectangle src = { view.x * BACKGROUND_PARALLAX / scale, view.y * BACKGROUND_PARALLAX / scale,
+			Width() / scale, Height() / scale };
+		out.Sprite(RenderLayer::BACKGROUND, TextureSlot::BACKGROUND, src, { 0, 0, (float)Width(), (float)Height() }, { 0, 0 }, 0.0f, WHITE);
 	}
 
-	void Draw() const {
-		if (hasTexture) {
-			float scale = 0.2f; // Ustaw skalę według potrzeb
-			Vector2 dstPos = {
-				transform.position.x - (texture.width * scale) * 0.5f,
-				transform.position.y - (texture.height * scale) * 0.5f
-			};
-			DrawTextureEx(texture, dstPos, 0.0f, scale, WHITE);
+	// Sorts and draws one frame, then waits out the rest of the frame budget.
+	// `view` is the world-space box on screen, the camera maps it to the window.
+	void Submit(RenderCommandBuffer& buffer, Rectangle view) {
+		double submitStart = GetTime();
+		buffer.Sort();
+
+		float scale = scaler.Scale();
+		int sceneW = static_cast<int>(screenW * scale);
+		int sceneH = static_cast<int>(screenH * scale);
+		Camera2D worldCamera{};
+		worldCamera.target = { view.x, view.y };
+		worldCamera.zoom = scale;
+		Camera2D screenCamera{};
+		screenCamera.zoom = scale;
+
+		drawCalls = static_cast<int>(buffer.Size());
+		materialSwitches = 0;
+		lastMaterial = -1;
+
+		// Scene at reduced resolution
+		size_t i = 0;
+		BeginTextureMode(sceneTarget);
+		BeginScissorMode(0, 0, sceneW, sceneH);
+		ClearBackground(BLACK);
+		int camera = -1; // 0 screen, 1 world
+		for (; i < buffer.Size() && !IsOverlay(buffer[i].layer); ++i) {
+			const DrawCommand& cmd = buffer[i];
+			int wanted = IsScreenSpace(cmd.layer) ? 0 : 1;
+			if (wanted != camera) {
+				if (camera >= 0) EndMode2D();
+				BeginMode2D(wanted ? worldCamera : screenCamera);
+				camera = wanted;
+			}
+			Execute(buffer, cmd);
 		}
-		else if (type == WeaponType::BULLET) {
-			DrawCircleV(transform.position, 5.f, WHITE);
+		if (camera >= 0) EndMode2D();
+		EndScissorMode();
+		EndTextureMode();
+
+		// Upscale, then the overlay layers at native resolution.
+		// Render textures are stored bottom-up, hence the negative source height.
+		BeginDrawing();
+		Rectangle src = { 0, (float)(screenH - sceneH), (float)sceneW, -(float)sceneH };
+		DrawTexturePro(sceneTarget.texture, src, { 0, 0, (float)screenW, (float)screenH }, { 0, 0 }, 0.0f, WHITE);
+		for (; i < buffer.Size(); ++i) {
+			Execute(buffer, buffer[i]);
 		}
-		else {
-			static constexpr float LASER_LENGTH = 30.f;
-			Rectangle lr = { transform.position.x - 2.f, transform.position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
-			DrawRectangleRec(lr, RED);
+		if (capture.Active()) {
+			PROFILE_ZONE("Render.Capture");
+			capture.Collect();
+			if (captureRequested) capture.Grab(GetRenderWidth(), GetRenderHeight(), captureTime);
+			captureRequested = false;
+			capture.PublishCounters();
 		}
+		EndDrawing();
+
+		// Rendering may use what the rest of the frame left of the budget
+		double now = GetTime();
+		double renderMs = (now - submitStart) * 1000.0;
+		double frameMs = (now - frameStart) * 1000.0;
+		double budgetMs = 1000.0 / (targetFps > 0 ? targetFps : C_SCALING_FPS);
+		double otherMs = frameMs - renderMs;
+		scaler.Update(renderMs, std::max(budgetMs - otherMs, budgetMs * MIN_RENDER_SHARE));
+		if (targetFps > 0 && frameMs < budgetMs) {
+			WaitTime((budgetMs - frameMs) / 1000.0);
+		}
+		frameStart = GetTime();
+
+		Profiler::Instance().SetCounter("Draw commands", static_cast<long long>(buffer.Size()));
+		Profiler::Instance().SetCounter("Draw material switches", materialSwitches);
+		Profiler::Instance().SetCounter("Render scale %", static_cast<long long>(scale * 100.f + 0.5f));
+		Profiler::Instance().SetCounter("Scene pixels", static_cast<long long>(sceneW) * sceneH);
 	}
 
-	Vector2 GetPosition() const {
-		return transform.position;
+	int GetDrawCalls() const {
+		return drawCalls;
 	}
 
-	float GetRadius() const {
-		return (type == WeaponType::BULLET) ? 5.f : 2.f;
+	int Width() const {
+		return screenW;
 	}
 
-	int GetDamage() const {
-		return baseDamage;
+	int Height() const {
+		return screenH;
 	}
 
 private:
-	TransformA transform;
-	Physics    physics;
-	int        baseDamage;
-	WeaponType type;
-	Texture2D  texture;
-	bool       hasTexture;
-};
+	Renderer() = default;
 
-inline static Projectile MakeProjectile(WeaponType wt,
-	const Vector2 pos,
-	float speed)
-{
-	Vector2 vel{ 0, -speed };
-	if (wt == WeaponType::LASER) {
-		return Projectile(pos, vel, 20, wt);
-	}
-	else {
-		return Projectile(pos, vel, 10, wt);
+	void Execute(const RenderCommandBuffer& buffer, const DrawCommand& cmd) {
+		int material = RenderCommandBuffer::Material(cmd);
+		if (material != lastMaterial) {
+			++materialSwitches;
+			lastMaterial = material;
+		}
+
+		switch (cmd.op) {
+		case DrawOp::SPRITE: {
+			const Texture2D& texture = GetTexture(cmd.texture);
+			Rectangle src = (cmd.src.width != 0.f) ? cmd.src : Rectangle{ 0, 0, (float)texture.width, (float)texture.height };
+			DrawTexturePro(texture, src, cmd.dst, cmd.position, cmd.size, cmd.color);
+			break;
+		}
+		case DrawOp::RECT:
+			DrawRectangleRec(cmd.dst, cmd.color);
+			break;
+		case DrawOp::RECT_LINES:
+			DrawRectangleLinesEx(cmd.dst, cmd.size, cmd.color);
+			break;
+		case DrawOp::CIRCLE:
+			DrawCircleV(cmd.position, cmd.size, cmd.color);
+			break;
+		case DrawOp::TEXT: {
+			const char* str = buffer.TextOf(cmd);
+			int fontSize = static_cast<int>(cmd.size);
+			int x = static_cast<int>(cmd.position.x);
+			if (cmd.centered) x -= MeasureText(str, fontSize) / 2;
+			DrawText(str, x, static_cast<int>(cmd.position.y), fontSize, cmd.color);
+			break;
+		}
+		}
 	}
-}
 
-// --- SHIP HIERARCHY ---
-class Ship {
+	int screenW{};
+	int screenH{};
+	std::array<Texture2D, static_cast<size_t>(TextureSlot::COUNT)> textures{};
+	RenderTexture2D sceneTarget{};
+	ResolutionScaler scaler;
+	FrameReadback capture;
+	bool captureRequested = false;
+	double captureTime = 0.0;
+	int targetFps = 60;
+	double frameStart = 0.0;
+
+	int drawCalls = 0;
+	int materialSwitches = 0;
+	int lastMaterial = -1;
+
+	static constexpr float BACKGROUND_PARALLAX = 0.25f;
+	static constexpr int C_SCALING_FPS = 60;          // budget the scaler aims for when the limiter is off
+	static constexpr double MIN_RENDER_SHARE = 0.25;  // of the frame budget, even when the simulation eats the rest
+};
+
+// --- AUTOPILOT ---
+// Plays through the same PlayerInput the keyboard produces. Each tick it finds
+// the asteroids, gunships and enemy shots that will pass closest to the ship
+// within a short horizon and steers away from them, otherwise lines up under
+// an asteroid and fires. Overheat is managed with hysteresis, and the E-skill
+// is spent when the ship is crowded. Asteroids come from one broadphase query
+// around the ship, sized so the fastest of them can only become a threat from
+// inside it; targets farther than TARGET_RANGE are ignored.
+class Autopilot {
 public:
-	Ship(int screenW, int screenH) {
-		transform.position = {
-												 screenW * 0.5f,
-												 screenH * 0.5f
+	explicit Autopilot(const SimConfig& config) {
+		nearby.reserve(config.ActiveCapacity());
+	}
+
+	PlayerInput Think(const Simulation& sim) {
+		PlayerInput in;
+		const PlayerShip& ship = sim.GetPlayer();
+		if (!ship.IsAlive()) {
+			in.restart = true;
+			return in;
+		}
+
+		Vector2 pos = ship.GetPosition();
+		WeaponType weapon = sim.GetWeapon();
+		float shotSpeed = ship.GetSpacing(weapon) * ship.GetFireRate(weapon);
+
+		Vector2 dodge{};
+		int threats = 0;
+		int crowd = 0;
+		float bestTargetScore = FLT_MAX;
+		float targetDx = 0.f;
+		float targetRadius = 0.f;
+
+		// An asteroid can only pass within reach if it starts within HORIZON * speed + reach
+		float range = std::max({ HORIZON * sim.MaxAsteroidSpeed() + ship.GetRadius() + SAFETY_MARGIN, CROWD_RADIUS, TARGET_RANGE });
+		auto scan = [&](const Asteroid& a) {
+			Vector2 rel = Vector2Subtract(a.GetPosition(), pos);
+			Vector2 vel = a.GetVelocity();
+			float reach = a.GetRadius() + ship.GetRadius() + SAFETY_MARGIN;
+			float distSq = Vector2LengthSqr(rel);
+			if (distSq < CROWD_RADIUS * CROWD_RADIUS) ++crowd;
+			Avoid(rel, vel, reach, dodge, threats);
+
+			// Shots only fly up - pick the asteroid above that is cheapest to line up with
+			if (rel.y < 0.f && rel.y >= -range && fabsf(rel.x) <= range) {
+				float tHit = -rel.y / shotSpeed;
+				float dx = rel.x + vel.x * tHit;
+				float score = fabsf(dx) + fabsf(rel.y) * 0.25f;
+				if (score < bestTargetScore) {
+					bestTargetScore = score;
+					targetDx = dx;
+					targetRadius = a.GetRadius();
+				}
+			}
 		};
-		hp = 100;
-		speed = 400.f;
-		alive = true;
+		const std::vector<Asteroid>& asteroids = sim.GetAsteroids();
+		if (sim.CollectAsteroidsNear({ pos.x - range, pos.y - range, 2.f * range, 2.f * range }, nearby)) {
+			for (uint32_t i : nearby) scan(asteroids[i]);
+		} else {
+			for (const Asteroid& a : asteroids) scan(a);
+		}
 
-		// per-weapon fire rate & spacing
-		fireRateLaser = 18.f; // shots/sec
-		fireRateBullet = 22.f;
-		spacingLaser = 40.f; // px between lasers
-		spacingBullet = 20.f;
+		for (const Projectile& p : sim.GetProjectiles()) {
+			if (p.GetFilter().layer != LAYER_ENEMY_SHOT) continue;
+			Avoid(Vector2Subtract(p.GetPosition(), pos), p.GetVelocity(), p.GetRadius() + ship.GetRadius() + SAFETY_MARGIN, dodge, threats);
+		}
+		for (const EnemyShip& g : sim.GetGunships()) {
+			Avoid(Vector2Subtract(g.GetPosition(), pos), g.GetVelocity(), g.GetRadius() + ship.GetRadius() + SAFETY_MARGIN, dodge, threats);
+		}
+
+		// Steering: dodging wins, otherwise line up; always drift back toward the world center
+		Vector2 move = dodge;
+		if (threats == 0 && bestTargetScore < FLT_MAX) {
+			move.x = Clamp(targetDx / ALIGN_DISTANCE, -1.f, 1.f);
+		}
+		Vector2 home = { sim.WorldWidth() * 0.5f, sim.WorldHeight() * 0.5f };
+		Vector2 toHome = Vector2Subtract(home, pos);
+		move.x += Clamp(toHome.x / (sim.WorldWidth() * 0.5f), -1.f, 1.f) * HOME_PULL;
+		move.y += Clamp(toHome.y / (sim.WorldHeight() * 0.5f), -1.f, 1.f) * HOME_PULL;
+		in.move = { Clamp(move.x, -1.f, 1.f), Clamp(move.y, -1.f, 1.f) };
+
+		// Fire with hysteresis so the gun rarely locks up, unless overheating on purpose for the skill
+		float heat = ship.GetOverheatPercent();
+		if (heat > HEAT_STOP) holdFire = true;
+		if (heat < HEAT_RESUME) holdFire = false;
+		bool crowded = crowd >= CROWD_COUNT;
+		bool aligned = bestTargetScore < FLT_MAX && fabsf(targetDx) < targetRadius;
+		in.fire = ship.CanShoot() && (crowded || (aligned && !holdFire));
+		in.skill = ship.IsOverheated() && !ship.overheatSkillUsed && (crowded || threats > 0);
+		return in;
 	}
-	virtual ~Ship() = default;
-	virtual void Update(float dt) = 0;
-	virtual void Draw() const = 0;
 
-	void TakeDamage(int dmg) {
-		if (!alive) return;
-		hp -= dmg;
-		if (hp <= 0) alive = false;
+private:
+	// Pushes `dodge` away from a body at `rel` moving with `vel` if its closest
+	// approach to a ship that holds still comes within `reach`
+	static void Avoid(Vector2 rel, Vector2 vel, float reach, Vector2& dodge, int& threats) {
+		float vv = Vector2LengthSqr(vel);
+		float t = (vv > 0.f) ? Clamp(-Vector2DotProduct(rel, vel) / vv, 0.f, HORIZON) : 0.f;
+		Vector2 closest = Vector2Add(rel, Vector2Scale(vel, t));
+		float miss = Vector2Length(closest);
+		if (miss >= reach) return;
+		++threats;
+		Vector2 away = (miss > 1e-3f) ? Vector2Scale(closest, -1.f / miss)
+			: Vector2Normalize(Vector2{ -vel.y, vel.x });
+		float urgency = (1.f - t / HORIZON) * (reach - miss) / reach;
+		dodge = Vector2Add(dodge, Vector2Scale(away, 0.25f + urgency * 4.f));
 	}
 
-	bool IsAlive() const {
-		return alive;
+	static constexpr float HORIZON = 1.2f;        // seconds of look-ahead for threats
+	static constexpr float SAFETY_MARGIN = 40.f;
+	static constexpr float CROWD_RADIUS = 350.f;
+	static constexpr float TARGET_RANGE = 700.f;  // about the distance from the ship to the top of the view
+	static constexpr int   CROWD_COUNT = 6;
+	static constexpr float ALIGN_DISTANCE = 60.f;
+	static constexpr float HOME_PULL = 0.35f;
+	static constexpr float HEAT_STOP = 0.85f;
+	static constexpr float HEAT_RESUME = 0.4f;
+
+	bool holdFire = false;
+	std::vector<uint32_t> nearby; // asteroid indices from the broadphase query, reused every tick
+};
+
+// --- SOAK LOG ---
+// CSV report of a long session: one row per interval of simulated time and one
+// per death. Enough to spot leaks (live heap bytes) and slowdowns (tick cost).
+class SoakLog {
+public:
+	SoakLog(const char* path, uint64_t seed) {
+		file = (path && *path) ? std::fopen(path, "w") : nullptr;
+		out = file ? file : stdout;
+		std::fprintf(out, "# seed %llu\n", static_cast<unsigned long long>(seed));
+		std::fprintf(out, "event,sim_s,wall_s,lives,score,survival_s,best_survival_s,best_score,"
+			"asteroids,asteroids_hw,projectiles,projectiles_hw,tick_avg_us,tick_max_us,allocs,live_bytes\n");
+		start = std::chrono::steady_clock::now();
 	}
 
-	Vector2 GetPosition() const {
-		return transform.position;
+	~SoakLog() {
+		if (file) std::fclose(file);
 	}
 
-	virtual float GetRadius() const = 0;
+	void OnTick(const Simulation& sim, double tickUs) {
+		bool alive = sim.GetPlayer().IsAlive();
+		size_t a = sim.GetAsteroids().size();
+		size_t p = sim.GetProjectiles().size();
+		asteroidsHw = std::max(asteroidsHw, a);
+		projectilesHw = std::max(projectilesHw, p);
+		tickSum += tickUs;
+		tickMax = std::max(tickMax, tickUs);
+		++ticks;
+
+		if (alive) lastScore = sim.GetScore();
+		if (wasAlive && !alive) {
+			double survival = sim.GetTime() - lifeStart;
+			bestSurvival = std::max(bestSurvival, survival);
+			bestScore = std::max(bestScore, lastScore);
+			Row("death", sim, survival);
+		}
+		if (!wasAlive && alive) {
+			lifeStart = sim.GetTime();
+			++lives;
+		}
+		wasAlive = alive;
+
+		if (sim.GetTime() >= nextRow) {
+			Row("interval", sim, alive ? sim.GetTime() - lifeStart : 0.0);
+			nextRow += INTERVAL;
+			tickSum = 0.0;
+			tickMax = 0.0;
+			ticks = 0;
+		}
+	}
 
-	int GetHP() const {
-		return hp;
+	void Finish(const Simulation& sim) {
+		Row("end", sim, wasAlive ? sim.GetTime() - lifeStart : 0.0);
 	}
 
-	float GetFireRate(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? fireRateLaser : fireRateBullet;
+private:
+	void Row(const char* event, const Simulation& sim, double survival) {
+		std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+		std::fprintf(out, "%s,%.1f,%.1f,%d,%d,%.1f,%.1f,%d,%zu,%zu,%zu,%zu,%.2f,%.2f,%llu,%lld\n",
+			event, sim.GetTime(), wall.count(), lives, lastScore, survival, bestSurvival, bestScore,
+			sim.GetAsteroids().size(), asteroidsHw, sim.GetProjectiles().size(), projectilesHw,
+			ticks ? tickSum / ticks : 0.0, tickMax,
+			static_cast<unsigned long long>(Memory::allocCount.load(std::memory_order_relaxed)),
+			static_cast<long long>(Memory::liveBytes.load(std::memory_order_relaxed)));
+		std::fflush(out);
 	}
 
-	float GetSpacing(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? spacingLaser : spacingBullet;
+	static constexpr double INTERVAL = 60.0; // simulated seconds between rows
+
+	std::FILE* file = nullptr;
+	std::FILE* out = nullptr;
+	std::chrono::steady_clock::time_point start;
+
+	bool wasAlive = true;
+	double lifeStart = 0.0;
+	int lives = 1;
+	int lastScore = 0;
+	int bestScore = 0;
+	double bestSurvival = 0.0;
+	double nextRow = INTERVAL;
+
+	size_t asteroidsHw = 0;
+	size_t projectilesHw = 0;
+	double tickSum = 0.0;
+	double tickMax = 0.0;
+	uint64_t ticks = 0;
+};
+
+// --- SIMULATION THREAD ---
+// Window keys that change the simulation or what it records, forwarded with the input
+enum class SimCommand : uint8_t { NONE, SPAWN_SHAPE, STRESS_MODE, BRUTE_FORCE, AUTOPILOT, CHUNKS, PROFILER };
+
+struct SimMessage {
+	PlayerInput input;                    // NONE: keyboard state of one window frame
+	SimCommand command = SimCommand::NONE;
+	int value = 0;                        // SPAWN_SHAPE: the AsteroidShape
+};
+
+// Where the F1 overlay goes: the simulation's profiler rows, then the window's below them
+struct OverlayLayout {
+	float x;
+	float y;
+	int fontSize;
+
+	float Row(int row) const {
+		return y + row * (fontSize + 4.f);
 	}
+};
 
-protected:
-	TransformA transform;
-	int        hp;
-	float      speed;
-	bool       alive;
-	float      fireRateLaser;
-	float      fireRateBullet;
-	float      spacingLaser;
-	float      spacingBullet;
+// Everything the window needs to draw one tick. Written by the simulation
+// thread, read-only for the window until the slot comes round again.
+struct RenderSnapshot {
+	RenderCommandBuffer world; // world layers and the simulation's debug overlays, culled to the view
+	Rectangle view{};
+	int hp = 0;
+	int score = 0;
+	WeaponType weapon = WeaponType::LASER;
+	float overheat = 0.f;
+	int profilerRows = 0;      // overlay rows the simulation profiler took, 0 when hidden
+	uint64_t tick = 0;         // 0 until the first tick is published
+	std::chrono::steady_clock::time_point published;
 };
 
-class PlayerShip :public Ship {
+// Writes what the window draws for one tick of a Simulation into a snapshot:
+// the world culled to the view, the simulation's debug overlays and the HUD
+// values. The simulation thread records every tick, headless capture only the
+// ticks it keeps.
+class SnapshotRecorder {
 public:
-	// --- OVERHEAT ---
-	float overheat = 0.0f;
-	float overheatCooldown = 0.0f;
-	bool overheated = false;
-	static constexpr float OVERHEAT_MAX = 100.0f;
-	static constexpr float OVERHEAT_PER_SHOT = 3.0f; // ile za 1 strzał
-	static constexpr float OVERHEAT_COOLDOWN_RATE = 30.0f; // ile schodzi na sekundę
-	static constexpr float OVERHEAT_COOLDOWN_DELAY = 1.0f; // po strzale, ile czeka zanim zacznie chłodzić
-	bool overheatSkillUsed = false;
-
-	PlayerShip(int w, int h) : Ship(w, h) {
-		texture = LoadTexture("spaceship2.png");
-		GenTextureMipmaps(&texture);                                                        // Generate GPU mipmaps for a texture
-		SetTextureFilter(texture, 2);
-		scale = 0.25f;
-		bulletTexture = LoadTexture("bullet.png");
-	}
-	~PlayerShip() {
-		UnloadTexture(texture);
-		UnloadTexture(bulletTexture);
-	}
-
-	void Update(float dt) override {
-		if (alive) {
-			if (IsKeyDown(KEY_W)) transform.position.y -= speed * dt;
-			if (IsKeyDown(KEY_S)) transform.position.y += speed * dt;
-			if (IsKeyDown(KEY_A)) transform.position.x -= speed * dt;
-			if (IsKeyDown(KEY_D)) transform.position.x += speed * dt;
+	explicit SnapshotRecorder(OverlayLayout overlay) : overlay(overlay) {}
+
+	void ToggleChunks() {
+		showChunks = !showChunks;
+	}
+
+	void ToggleProfiler() {
+		showProfiler = !showProfiler;
+	}
+
+	void Record(const Simulation& sim, RenderSnapshot& out, uint64_t tick) const {
+		const PlayerShip& player = sim.GetPlayer();
+		out.view = sim.GetView();
+		out.hp = player.GetHP();
+		out.score = sim.GetScore();
+		out.weapon = sim.GetWeapon();
+		out.overheat = player.overheat;
+
+		out.world.Clear();
+		RecordWorld(sim, out.world);
+		out.profilerRows = 0;
+		if (showProfiler) {
+			Profiler::Instance().ForEachOverlayLine([&](const char* line, int row, bool isCounter) {
+				out.world.Text(RenderLayer::DEBUG, line, { overlay.x, overlay.Row(row) }, overlay.fontSize, isCounter ? SKYBLUE : LIGHTGRAY);
+			});
+			out.profilerRows = Profiler::Instance().OverlayRows();
 		}
-		else {
-			transform.position.y += speed * dt;
+		out.tick = tick;
+		out.published = std::chrono::steady_clock::now();
+	}
+
+private:
+	// The active set reaches well past the screen, only what is in view gets recorded
+	void RecordWorld(const Simulation& sim, RenderCommandBuffer& out) const {
+		Rectangle view = sim.GetView();
+		if (showChunks) {
+			RecordChunks(sim, out);
 		}
-		// Chłodzenie broni
-		if (overheat > 0.0f) {
-			if (overheatCooldown > 0.0f)
-				overheatCooldown -= dt;
-			else
-				overheat = std::max(0.0f, overheat - OVERHEAT_COOLDOWN_RATE * dt);
+		for (const auto& projPtr : sim.GetProjectiles()) {
+			if (Utils::CircleInRect(projPtr.GetPosition(), C_PROJECTILE_CULL_RADIUS, view)) projPtr.Draw(out);
 		}
-		if (overheat >= OVERHEAT_MAX) {
-			overheated = true;
-			overheat = OVERHEAT_MAX;
+		const std::vector<Asteroid>& asteroids = sim.GetAsteroids();
+		const PlayerShip& player = sim.GetPlayer();
+		Vector2 playerPos = player.GetPosition();
+		ForEachAsteroidKind([&](auto kind) {
+			constexpr AsteroidKind K = decltype(kind)::value;
+			for (uint32_t i = sim.KindBegin(K); i < sim.KindEnd(K); ++i) {
+				if (Utils::CircleInRect(asteroids[i].GetPosition(), asteroids[i].GetRadius(), view)) asteroids[i].Draw<K>(out, playerPos);
+			}
+		});
+
+		for (const EnemyShip& g : sim.GetGunships()) {
+			if (Utils::CircleInRect(g.GetPosition(), g.GetRadius(), view)) g.Draw(out, sim.GetTime());
 		}
-		if (overheated && overheat <= 0.0f) {
-			overheated = false;
-			overheatSkillUsed = false;
+
+		player.Draw(out, sim.GetTime());
+		out.RectLines(RenderLayer::WORLD_DEBUG, { 0, 0, sim.WorldWidth(), sim.WorldHeight() }, 8.f, RED);
+	}
+
+	// F4 - chunk activity overlay: green active, yellow reduced rate, grey sleeping
+	void RecordChunks(const Simulation& sim, RenderCommandBuffer& out) const {
+		const ChunkGrid& grid = sim.GetChunks();
+		Rectangle view = sim.GetView();
+		float size = grid.ChunkSize();
+		int x0 = std::max(static_cast<int>(view.x / size), 0);
+		int y0 = std::max(static_cast<int>(view.y / size), 0);
+		int x1 = std::min(static_cast<int>((view.x + view.width) / size), grid.Columns() - 1);
+		int y1 = std::min(static_cast<int>((view.y + view.height) / size), grid.Rows() - 1);
+		char label[64];
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				int c = y * grid.Columns() + x;
+				Color color = GRAY;
+				if (grid.Activity(c) == ChunkActivity::ACTIVE) color = GREEN;
+				else if (grid.Activity(c) == ChunkActivity::REDUCED) color = YELLOW;
+				out.RectLines(RenderLayer::WORLD_DEBUG, { x * size, y * size, size, size }, 2.f, Fade(color, 0.5f));
+				std::snprintf(label, sizeof(label), "%d,%d  parked %u", x, y, grid.Count(c));
+				out.Text(RenderLayer::WORLD_DEBUG, label, { x * size + 12, y * size + 12 }, 24, Fade(color, 0.8f));
+			}
 		}
 	}
 
-	void Draw() const override {
-		if (!alive && fmodf(GetTime(), 0.4f) > 0.2f) return;
-		Vector2 dstPos = {
-										 transform.position.x - (texture.width * scale) * 0.5f,
-										 transform.position.y - (texture.height * scale) * 0.5f
-		};
-		DrawTextureEx(texture, dstPos, 0.0f, scale, WHITE);
+	static constexpr float C_PROJECTILE_CULL_RADIUS = 40.f; // covers the laser streak and the textured bullet
 
-		// --- HEALTHBAR ---
-		// Parametry paska
-		float barWidth = 60.0f;
-		float barHeight = 8.0f;
-		float barOffsetY = (texture.height * scale) * 0.5f + 12.0f; // odległość pod statkiem
+	OverlayLayout overlay;
+	bool showChunks = false;
+	bool showProfiler = false;
+};
 
-		float hpPercent = (float)hp / 100.0f;
-		float filledWidth = barWidth * hpPercent;
+// Steps the Simulation at a fixed rate on a thread of its own, so a slow draw
+// no longer delays the next tick and a slow tick no longer delays the draw.
+// The window thread reaches it only through two lock-free channels: input and
+// key commands go in through an SpscQueue, every tick comes out as a
+// RenderSnapshot in a TripleBuffer. The window draws the newest snapshot,
+// skipping those it was too slow for and repeating one when no tick finished in time.
+class SimulationThread {
+public:
+	static constexpr int C_WARMUP_TICKS = 120;
+	static constexpr float C_DT = 1.f / 60.f;
 
-		Vector2 barPos = {
-			transform.position.x - barWidth * 0.5f,
-			transform.position.y + barOffsetY
-		};
+	// benchTicks > 0 runs that many ticks after the warmup unpaced, prints the profile and stops
+	SimulationThread(Simulation& sim, bool autopilot, int benchTicks, OverlayLayout overlay)
+		: sim(sim), pilot(sim.GetConfig()), recorder(overlay), autopilot(autopilot), benchTicks(benchTicks) {}
 
-		// Tło paska (szary)
-		DrawRectangleV(barPos, { barWidth, barHeight }, DARKGRAY);
-		// Wypełnienie (zielony/czerwony)
-		Color fillColor = (hpPercent > 0.5f) ? GREEN : (hpPercent > 0.2f ? ORANGE : RED);
-		DrawRectangleV(barPos, { filledWidth, barHeight }, fillColor);
-		// Ramka
-		DrawRectangleLines((int)barPos.x, (int)barPos.y, (int)barWidth, (int)barHeight, BLACK);
+	~SimulationThread() {
+		Stop();
+	}
 
+	void Start() {
+		worker = std::thread([this]() { Loop(); });
+	}
 
-		// --- OVERHEAT BAR ---
-		float barWidth1 = 16.0f;
-		float barHeight1 = 80.0f;
-		float barOffsetX1 = (texture.width * scale) * 0.5f + 16.0f;
-		float barOffsetY1 = 0.0f;
+	void Stop() {
+		quit.store(true, std::memory_order_relaxed);
+		if (worker.joinable()) worker.join();
+	}
 
-		Vector2 barPos1 = {
-			transform.position.x + barOffsetX1,
-			transform.position.y - barHeight1 * 0.5f + barOffsetY1
-		};
+	// The bench run is over
+	bool Finished() const {
+		return finished.load(std::memory_order_acquire);
+	}
 
-		// Tło paska (ciemny szary)
-		DrawRectangleV(barPos1, { barWidth1, barHeight1 }, DARKGRAY);
+	// Window thread; false when the queue is full and the message is lost
+	bool Post(const SimMessage& message) {
+		return inbox.Push(message);
+	}
+
+	// Window thread reads, the simulation thread writes
+	TripleBuffer<RenderSnapshot>& Snapshots() {
+		return snapshots;
+	}
 
-		// Wypełnienie (czerwony)
-		float fillHeight1 = barHeight1 * GetOverheatPercent();
-		Vector2 fillPos1 = { barPos1.x, barPos1.y + barHeight1 - fillHeight1 };
-		DrawRectangleV(fillPos1, { barWidth1, fillHeight1 }, (overheated ? ORANGE : RED));
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void Loop() {
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(C_DT));
+		Clock::time_point next = Clock::now();
+		lastTick = next;
+		uint64_t tick = 0;
+
+		while (!quit.load(std::memory_order_relaxed)) {
+			Tick(++tick);
+			if (benchTicks > 0) {
+				if (tick >= static_cast<uint64_t>(C_WARMUP_TICKS + benchTicks)) {
+					std::printf("bench: %d ticks after %d warmup ticks, dt %.4f s\n", benchTicks, C_WARMUP_TICKS, C_DT);
+					std::printf("simulation thread:\n");
+					Profiler::Instance().PrintSummary(stdout);
+					break;
+				}
+				continue;
+			}
+			// Too far behind (stress mode, a debugger): slow down instead of catching up in a burst
+			next += period;
+			if (Clock::now() - next > period * C_MAX_LAG_TICKS) next = Clock::now();
+			std::this_thread::sleep_until(next);
+		}
+		finished.store(true, std::memory_order_release);
+	}
 
-		// Ramka
-		DrawRectangleLines((int)barPos1.x, (int)barPos1.y, (int)barWidth1, (int)barHeight1, BLACK);
+	void Tick(uint64_t tick) {
+		// Runs allocation-free once the buffers have grown to their working size
+		STEADY_STATE_REGION("Tick");
+		Clock::time_point start = Clock::now();
+		if (tick == C_WARMUP_TICKS) Profiler::Instance().ResetTotals();
 
-		// --- OVERHEATED TEXT ---
-		if (overheated && fmodf(GetTime(), 0.6f) < 0.3f) {
-			const char* txt = "OVERHEATED!";
-			int fontSize = 32;
-			int textWidth = MeasureText(txt, fontSize);
-			Vector2 textPos = {
-				transform.position.x - textWidth * 0.5f,
-				transform.position.y + (texture.height * scale) * 0.5f + 40.0f // 40px pod statkiem
-			};
-			DrawText(txt, (int)textPos.x, (int)textPos.y, fontSize, ORANGE);
+		PlayerInput input = TakeInput();
+		if (autopilot) input = pilot.Think(sim);
+		sim.Step(C_DT, input);
+		{
+			PROFILE_ZONE("Snapshot.Record");
+			recorder.Record(sim, snapshots.Back(), tick);
 		}
-		// --- PRESS E TEXT ---
-		if (overheated && fmodf(GetTime(), 0.8f) < 0.4f && !overheatSkillUsed) {
-			const char* txt = "PRESS E";
-			int fontSize = 28;
-			int textWidth = MeasureText(txt, fontSize);
-			Vector2 textPos = {
-				transform.position.x - textWidth * 0.5f,
-				transform.position.y + (texture.height * scale) * 0.5f + 80.0f // pod napisem OVERHEATED!
-			};
-			DrawText(txt, (int)textPos.x, (int)textPos.y, fontSize, YELLOW);
+		snapshots.Publish();
+
+		Clock::time_point now = Clock::now();
+		std::chrono::duration<float> dt = now - lastTick;
+		std::chrono::duration<float, std::milli> work = now - start;
+		lastTick = now;
+		Telemetry::Instance().EndTick({
+			dt.count(), work.count(),
+			static_cast<uint32_t>(sim.WorldPopulation()), static_cast<uint32_t>(sim.MaxAsteroids()),
+			static_cast<uint32_t>(sim.GetProjectiles().size()), static_cast<uint32_t>(sim.GetConfig().maxProjectiles),
+			sim.GetFrameSpawns(), sim.GetFrameCollisionTests(), sim.GetFrameMaskRejected()
+		});
+		Profiler::Instance().EndFrame();
+	}
+
+	// Applies the queued commands in order. Movement and fire follow the latest
+	// keyboard state; a key press counts if any frame since the last tick saw it.
+	PlayerInput TakeInput() {
+		PlayerInput input = held;
+		input.skill = false;
+		input.switchWeapon = false;
+		input.restart = false;
+		SimMessage m;
+		while (inbox.Pop(m)) {
+			switch (m.command) {
+			case SimCommand::NONE:
+				input.move = m.input.move;
+				input.fire = m.input.fire;
+				input.skill |= m.input.skill;
+				input.switchWeapon |= m.input.switchWeapon;
+				input.restart |= m.input.restart;
+				break;
+			case SimCommand::SPAWN_SHAPE:
+				sim.SetSpawnShape(static_cast<AsteroidShape>(m.value));
+				break;
+			case SimCommand::STRESS_MODE:
+				sim.SetStressMode(!sim.IsStressMode());
+				break;
+			case SimCommand::BRUTE_FORCE:
+				sim.SetBruteForceBroadphase(!sim.IsBruteForceBroadphase());
+				break;
+			case SimCommand::AUTOPILOT:
+				autopilot = !autopilot;
+				break;
+			case SimCommand::CHUNKS:
+				recorder.ToggleChunks();
+				break;
+			case SimCommand::PROFILER:
+				recorder.ToggleProfiler();
+				break;
+			}
 		}
+		held = input;
+		return input;
+	}
 
+	static constexpr int C_MAX_LAG_TICKS = 5;
+
+	Simulation& sim;
+	Autopilot pilot;
+	SnapshotRecorder recorder;
+	bool autopilot;
+	int benchTicks;
+	PlayerInput held;
+	Clock::time_point lastTick;
+
+	SpscQueue<SimMessage, 256> inbox;
+	TripleBuffer<RenderSnapshot> snapshots;
+	std::atomic<bool> quit{ false };
+	std::atomic<bool> finished{ false };
+	std::thread worker;
+};
+
+// Both channels as the window thread sees them: how old a snapshot is when its
+// frame starts submitting, ticks overwritten before any frame took them, frames
+// that drew the previous snapshot again, and input messages lost to a full queue
+class ThreadLinkStats {
+public:
+	void OnFrame(bool fresh, const RenderSnapshot& snapshot) {
+		if (!fresh) {
+			++repeated;
+			return;
+		}
+		if (lastTick != 0 && snapshot.tick > lastTick + 1) dropped += static_cast<long long>(snapshot.tick - lastTick - 1);
+		lastTick = snapshot.tick;
+		++delivered;
 	}
 
-	float GetRadius() const override {
-		return (texture.width * scale) * 0.5f;
+	void OnSubmit(const RenderSnapshot& snapshot) {
+		if (snapshot.tick == 0) return;
+		std::chrono::duration<double, std::micro> age = std::chrono::steady_clock::now() - snapshot.published;
+		latencyUs = age.count();
+		latencyMaxUs = std::max(latencyMaxUs, latencyUs);
+		latencySumUs += latencyUs;
+		++submitted;
 	}
 
-	Texture2D GetBulletTexture() const {
-		return bulletTexture;
+	void OnInputDropped() {
+		++inputsDropped;
 	}
 
-	bool CanShoot() const { return !overheated; }
-	float GetOverheatPercent() const { return overheat / OVERHEAT_MAX; }
-	bool IsOverheated() const { return overheated; }
+	void Publish() const {
+		Profiler::Instance().SetCounter("Snapshot latency us", static_cast<long long>(latencyUs));
+		Profiler::Instance().SetCounter("Snapshots dropped", dropped);
+		Profiler::Instance().SetCounter("Snapshots repeated", repeated);
+		Profiler::Instance().SetCounter("Inputs dropped", inputsDropped);
+	}
+
+	void Print(std::FILE* out) const {
+		std::fprintf(out, "snapshots: %lld drawn, %lld dropped, %lld repeated; latency avg %.0f us, max %.0f us; %lld inputs dropped\n",
+			delivered, dropped, repeated, submitted ? latencySumUs / submitted : 0.0, latencyMaxUs, inputsDropped);
+	}
 
 private:
-	Texture2D texture;
-	float     scale;
-	Texture2D bulletTexture;
+	uint64_t lastTick = 0;
+	long long delivered = 0;
+	long long dropped = 0;
+	long long repeated = 0;
+	long long submitted = 0;
+	long long inputsDropped = 0;
+	double latencyUs = 0.0;
+	double latencyMaxUs = 0.0;
+	double latencySumUs = 0.0;
+};
 
+// --- OPTIONS ---
+struct AppOptions {
+	int benchFrames = 0;        // --bench N: run N fixed-step ticks in stress mode, unpaced, print the profiles and quit
+	bool assertNoAlloc = false; // --assert-no-alloc: abort on any allocation inside a steady-state region
+	bool autopilot = false;     // --autopilot: the bot plays (also F6 in game)
+	bool headless = false;      // --headless: no window, autopilot at full speed
+	double soakSeconds = 3600;  // --soak S: simulated seconds for a headless session
+	uint64_t seed = 0;          // --seed N: 0 picks one from the clock
+	const char* logPath = nullptr; // --log FILE: headless CSV report, stdout by default
+	float renderScale = 0.f;    // --render-scale S: fixed scene resolution scale, 0 adapts to the frame time
+	const char* capturePath = nullptr; // --capture FILE: record a .gif, any other name gets raw RGBA frames
+	float captureScale = 0.5f;  // --capture-scale S: recording size relative to the window
+	int captureFps = 30;        // --capture-fps N: recorded frames per second (of game time when headless)
 };
 
+static AppOptions ParseOptions(int argc, char** argv) {
+	AppOptions opt;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+			opt.benchFrames = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--assert-no-alloc") == 0) {
+			opt.assertNoAlloc = true;
+		}
+		else if (std::strcmp(argv[i], "--autopilot") == 0) {
+			opt.autopilot = true;
+		}
+		else if (std::strcmp(argv[i], "--headless") == 0) {
+			opt.headless = true;
+		}
+		else if (std::strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+			opt.soakSeconds = std::max(1.0, std::atof(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			opt.seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+			opt.logPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+			opt.renderScale = static_cast<float>(std::atof(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			opt.capturePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--capture-scale") == 0 && i + 1 < argc) {
+			opt.captureScale = Clamp(static_cast<float>(std::atof(argv[++i])), 0.1f, 1.f);
+		}
+		else if (std::strcmp(argv[i], "--capture-fps") == 0 && i + 1 < argc) {
+			opt.captureFps = std::clamp(std::atoi(argv[++i]), 1, 60);
+		}
+		else {
+			std::fprintf(stderr, "unknown option '%s'\n", argv[i]);
+		}
+	}
+	if (opt.seed == 0) opt.seed = static_cast<uint64_t>(time(nullptr));
+	return opt;
+}
+
 // --- APPLICATION ---
 class Application {
 public:
@@ -625,227 +1257,312 @@ public:
 		return inst;
 	}
 
-	void Run() {
-		srand(static_cast<unsigned>(time(nullptr)));
-		Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Space ship");
-
-		auto player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-
-		player->overheat = 0.0f;
-		player->overheated = false;
-		player->overheatCooldown = 0.0f;
+	// Returns the process exit code
+	int Run(const AppOptions& options) {
+		Memory::steadyStateAsserts = options.assertNoAlloc;
+		if (options.headless) return RunHeadless(options);
 
-		float spawnTimer = 0.f;
-		float spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-		WeaponType currentWeapon = WeaponType::LASER;
-		float shotTimer = 0.f;
-
-		score = 0;
-
-
-
-		while (!WindowShouldClose()) {
-			float dt = GetFrameTime();
-			spawnTimer += dt;
+		const bool bench = options.benchFrames > 0;
+		if (bench) SetTraceLogLevel(LOG_WARNING);
+		Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Space ship");
+		Telemetry::Instance().Init();
+		if (bench) Renderer::Instance().SetFrameRateLimit(0);
+		Renderer::Instance().GetScaler().SetFixed(options.renderScale);
+		StartCapture(options, GetTime());
+
+		Simulation sim(C_WIDTH, C_HEIGHT, options.seed);
+		sim.SetStressMode(bench);
+		SimulationThread simThread(sim, options.autopilot, options.benchFrames, C_OVERLAY);
+		simThread.Start();
+		TripleBuffer<RenderSnapshot>& snapshots = simThread.Snapshots();
+		int frameIndex = 0;
+
+		while (!WindowShouldClose() && !simThread.Finished()) {
+			// Everything below runs allocation-free once the buffers have grown to their working size
+			STEADY_STATE_REGION("Frame");
+			if (frameIndex == C_WARMUP_FRAMES) {
+				Profiler::Instance().ResetTotals();
+				link = {};
+			}
 
-			// Update player
-			player->Update(dt);
+			ForwardInput(simThread);
 
-			// Restart logic
-			if (!player->IsAlive() && IsKeyPressed(KEY_R)) {
-				player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-				player->overheat = 0.0f;
-				player->overheated = false;
-				player->overheatCooldown = 0.0f;
-				asteroids.clear();
-				projectiles.clear();
-				spawnTimer = 0.f;
-				spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-				score = 0; // <-- DODAJ TO
-			}
-			// Asteroid shape switch
-			if (IsKeyPressed(KEY_ONE)) {
-				currentShape = AsteroidShape::TRIANGLE;
-			}
-			if (IsKeyPressed(KEY_TWO)) {
-				currentShape = AsteroidShape::SQUARE;
-			}
-			if (IsKeyPressed(KEY_THREE)) {
-				currentShape = AsteroidShape::PENTAGON;
-			}
-			if (IsKeyPressed(KEY_FOUR)) {
-				currentShape = AsteroidShape::RANDOM;
-			}
-			if (IsKeyPressed(KEY_FIVE)) {
-				currentShape = static_cast<AsteroidShape>(6); // Chasing asteroid
+			bool fresh = snapshots.Acquire();
+			const RenderSnapshot& snapshot = snapshots.Front();
+			link.OnFrame(fresh, snapshot);
+			if (frameIndex >= C_WARMUP_FRAMES && snapshot.tick >= SimulationThread::C_WARMUP_TICKS) {
+				Memory::steadyStateArmed = true;
 			}
 
-			// Weapon switch
-			if (IsKeyPressed(KEY_TAB)) {
-				currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+			// Record the frame around the snapshot, then let the renderer sort and submit it
+			{
+				PROFILE_ZONE("Render.Record");
+				RecordFrame(snapshot);
 			}
-
-			// Shooting
 			{
-				if (player->IsAlive() && IsKeyDown(KEY_SPACE) && player->CanShoot()) {
-					shotTimer += dt;
-					float interval = 1.f / player->GetFireRate(currentWeapon);
-					float projSpeed = player->GetSpacing(currentWeapon) * player->GetFireRate(currentWeapon);
-
-					while (shotTimer >= interval) {
-						Vector2 p = player->GetPosition();
-						p.y -= player->GetRadius();
-						projectiles.push_back(MakeProjectile(currentWeapon, p, projSpeed));
-						shotTimer -= interval;
-
-						// --- OVERHEAT ---
-						player->overheat += PlayerShip::OVERHEAT_PER_SHOT;
-						player->overheatCooldown = PlayerShip::OVERHEAT_COOLDOWN_DELAY;
-						if (player->overheat >= PlayerShip::OVERHEAT_MAX) {
-							player->overheated = true;
-							player->overheat = PlayerShip::OVERHEAT_MAX;
-						}
-					}
-				}
-				else {
-					float maxInterval = 1.f / player->GetFireRate(currentWeapon);
-
-					if (shotTimer > maxInterval) {
-						shotTimer = fmodf(shotTimer, maxInterval);
-					}
-				}
-				if (player->IsAlive() && player->overheated && IsKeyPressed(KEY_E) && !player->overheatSkillUsed) {
-					const int numBullets = 50;
-					float angleStep = 2 * PI / numBullets;
-					float bulletSpeed = 600.0f;
-					Vector2 center = player->GetPosition();
-					for (int i = 0; i < numBullets; ++i) {
-						float angle = i * angleStep;
-						Vector2 dir = { cosf(angle), sinf(angle) };
-						Vector2 pos = center;
-						Vector2 vel = Vector2Scale(dir, bulletSpeed);
-						projectiles.push_back(
-							Projectile(pos, vel, 10, WeaponType::BULLET, player->GetBulletTexture())
-						);
-					}
-					player->overheatSkillUsed = true;
-				}
-
+				PROFILE_ZONE("Render.Submit");
+				link.OnSubmit(snapshot);
+				ScheduleCapture(GetTime());
+				Renderer::Instance().Submit(frame, snapshot.view);
 			}
+			link.Publish();
+			Telemetry::Instance().EndFrame(GetFrameTime(), Renderer::Instance().GetDrawCalls());
+			Profiler::Instance().SetCounter("Steady-state allocations",
+				static_cast<long long>(Memory::steadyStateViolations.load(std::memory_order_relaxed)));
+			Profiler::Instance().EndFrame();
+			++frameIndex;
+		}
+		simThread.Stop();
+		Renderer::Instance().FinishCapture(stderr);
+
+		if (bench) {
+			std::printf("render thread:\n");
+			Profiler::Instance().PrintSummary(stdout);
+			PrintRenderScale(stdout);
+			link.Print(stdout);
+		}
+		return CheckParkingFailures(sim);
+	}
 
-			// Spawn asteroids
-			if (spawnTimer >= spawnInterval && asteroids.size() < MAX_AST) {
-				asteroids.push_back(MakeAsteroid(C_WIDTH, C_HEIGHT, currentShape, [&player]() { return player->GetPosition(); }));
-				spawnTimer = 0.f;
-				spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-			}
+private:
+	Application() = default;
+
+	static PlayerInput ReadKeyboard() {
+		PlayerInput in;
+		if (IsKeyDown(KEY_W)) in.move.y -= 1.f;
+		if (IsKeyDown(KEY_S)) in.move.y += 1.f;
+		if (IsKeyDown(KEY_A)) in.move.x -= 1.f;
+		if (IsKeyDown(KEY_D)) in.move.x += 1.f;
+		in.fire = IsKeyDown(KEY_SPACE);
+		in.skill = IsKeyPressed(KEY_E);
+		in.switchWeapon = IsKeyPressed(KEY_TAB);
+		in.restart = IsKeyPressed(KEY_R);
+		return in;
+	}
 
-			// Update projectiles - check if in boundries and move them forward
-			{
-				auto projectile_to_remove = std::remove_if(projectiles.begin(), projectiles.end(),
-					[dt](auto& projectile) {
-						return projectile.Update(dt);
-					});
-				projectiles.erase(projectile_to_remove, projectiles.end());
-			}
+	// Fixed-step autopilot session with no window, as fast as the CPU allows.
+	// A capture needs a GL context, so with --capture the ticks it keeps are
+	// drawn into a hidden window; the tick times in the log do not include it.
+	int RunHeadless(const AppOptions& options) {
+		Simulation sim(C_WIDTH, C_HEIGHT, options.seed);
+		Autopilot pilot(sim.GetConfig());
+		SoakLog log(options.logPath, options.seed);
+		Telemetry::Instance().Init();
+		SnapshotRecorder recorder(C_OVERLAY);
+		RenderSnapshot shot;
+		if (options.capturePath) {
+			SetTraceLogLevel(LOG_WARNING);
+			Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Space ship", true);
+			Renderer::Instance().SetFrameRateLimit(0);
+			Renderer::Instance().GetScaler().SetFixed(options.renderScale > 0.f ? options.renderScale : 1.f);
+			StartCapture(options, 0.0);
+		}
+		int frameIndex = 0;
 
-			// Projectile-Asteroid collisions O(n^2)
-			for (auto pit = projectiles.begin(); pit != projectiles.end();) {
-				bool removed = false;
-
-				for (auto ait = asteroids.begin(); ait != asteroids.end(); ++ait) {
-					float dist = Vector2Distance((*pit).GetPosition(), (*ait)->GetPosition());
-					if (dist < (*pit).GetRadius() + (*ait)->GetRadius()) {
-						score += 10 * (*ait)->GetSize(); // 10 punktów za SMALL, 20 za MEDIUM, 40 za LARGE
-						ait = asteroids.erase(ait);
-						pit = projectiles.erase(pit);
-						removed = true;
-						break;
-					}
-				}
-				if (!removed) {
-					++pit;
-				}
+		while (sim.GetTime() < options.soakSeconds) {
+			STEADY_STATE_REGION("Tick");
+			if (frameIndex++ == C_WARMUP_FRAMES) {
+				Memory::steadyStateArmed = true;
 			}
 
-			// Asteroid-Ship collisions
-			{
-				auto remove_collision =
-					[&player, dt](auto& asteroid_ptr_like) -> bool {
-					if (player->IsAlive()) {
-						float dist = Vector2Distance(player->GetPosition(), asteroid_ptr_like->GetPosition());
-
-						if (dist < player->GetRadius() + asteroid_ptr_like->GetRadius()) {
-							player->TakeDamage(asteroid_ptr_like->GetDamage());
-							return true; // Mark asteroid for removal due to collision
-						}
-					}
-					if (!asteroid_ptr_like->Update(dt)) {
-						return true;
-					}
-					return false; // Keep the asteroid
-					};
-				auto asteroid_to_remove = std::remove_if(asteroids.begin(), asteroids.end(), remove_collision);
-				asteroids.erase(asteroid_to_remove, asteroids.end());
+			auto t0 = std::chrono::steady_clock::now();
+			sim.Step(C_BENCH_DT, pilot.Think(sim));
+			std::chrono::duration<double, std::micro> tick = std::chrono::steady_clock::now() - t0;
+
+			log.OnTick(sim, tick.count());
+			if (Renderer::Instance().IsCapturing() && ScheduleCapture(sim.GetTime())) {
+				PROFILE_ZONE("Capture.Draw");
+				recorder.Record(sim, shot, static_cast<uint64_t>(frameIndex));
+				RecordFrame(shot);
+				Renderer::Instance().Submit(frame, shot.view);
 			}
+			// No window: ticks run back to back, so the tick time is also the interval
+			float tickSec = static_cast<float>(tick.count() * 1e-6);
+			Telemetry::Instance().EndTick({
+				tickSec, tickSec * 1000.f,
+				static_cast<uint32_t>(sim.WorldPopulation()), static_cast<uint32_t>(sim.MaxAsteroids()),
+				static_cast<uint32_t>(sim.GetProjectiles().size()), static_cast<uint32_t>(sim.GetConfig().maxProjectiles),
+				sim.GetFrameSpawns(), sim.GetFrameCollisionTests(), sim.GetFrameMaskRejected()
+			});
+			Profiler::Instance().EndFrame();
+		}
+		log.Finish(sim);
+		Renderer::Instance().FinishCapture(stderr);
+		return CheckParkingFailures(sim);
+	}
 
-			// Render everything
-			{
-				Renderer::Instance().Begin();
+	// The parking pool holds the whole population, so an asteroid that did not
+	// fit means the pool was sized wrong: the run fails instead of carrying on degraded
+	static int CheckParkingFailures(const Simulation& sim) {
+		if (sim.GetParkingFailures() == 0) return 0;
+		std::fprintf(stderr, "error: %llu asteroids did not fit in the parking pool (%zu slots)\n",
+			static_cast<unsigned long long>(sim.GetParkingFailures()), sim.GetConfig().ParkingCapacity());
+		return 1;
+	}
 
-				DrawText(TextFormat("HP: %d", player->GetHP()),
-					10, 10, 48, GREEN); // większy rozmiar czcionki
+	void StartCapture(const AppOptions& options, double now) {
+		if (!options.capturePath) return;
+		if (!Renderer::Instance().StartCapture(options.capturePath, options.captureScale, options.captureFps)) {
+			std::fprintf(stderr, "capture: cannot open '%s'\n", options.capturePath);
+			return;
+		}
+		captureInterval = 1.0 / options.captureFps;
+		nextCapture = now;
+	}
 
-				const char* weaponName = (currentWeapon == WeaponType::LASER) ? "LASER" : "BULLET";
-				DrawText(TextFormat("Weapon: %s", weaponName),
-					10, 70, 48, BLUE); // większy rozmiar czcionki i przesunięcie w dół
+	// Asks the renderer to capture the next frame once `now` reaches the recording's
+	// next frame time. After a long stall it restarts from now instead of catching up.
+	bool ScheduleCapture(double now) {
+		if (!Renderer::Instance().IsCapturing() || now < nextCapture) return false;
+		Renderer::Instance().RequestCapture(now);
+		nextCapture += captureInterval;
+		if (nextCapture < now) nextCapture = now + captureInterval;
+		return true;
+	}
 
-				DrawText(TextFormat("Score: %d", score),
-					10, 130, 48, YELLOW); // pozycja pod HP i Weapon, rozmiar i kolor możesz zmienić
+	// Background, the snapshot's world, the HUD and the window's profiler rows into `frame`
+	void RecordFrame(const RenderSnapshot& snapshot) {
+		frame.Clear();
+		Renderer::Instance().RecordBackground(frame, snapshot.view);
+		frame.Append(snapshot.world);
+		DrawHud(snapshot, frame);
+		if (showProfiler) {
+			DrawProfiler(frame, snapshot.profilerRows > 0 ? snapshot.profilerRows + 1 : 0);
+		}
+	}
 
-				DrawText(TextFormat("Overheat: %.1f", player->overheat),
-					10, 190, 48, RED); // wyświetlanie poziomu przegrzania
+	// Keys are read here on the window thread; everything that changes the simulation goes through its queue
+	void ForwardInput(SimulationThread& simThread) {
+		auto post = [&](SimCommand command, int value) {
+			SimMessage m;
+			m.command = command;
+			m.value = value;
+			if (!simThread.Post(m)) link.OnInputDropped();
+		};
 
-				for (const auto& projPtr : projectiles) {
-					projPtr.Draw();
-				}
-				for (const auto& astPtr : asteroids) {
-					astPtr->Draw();
-				}
+		// Asteroid shape switch
+		if (IsKeyPressed(KEY_ONE)) {
+			post(SimCommand::SPAWN_SHAPE, static_cast<int>(AsteroidShape::TRIANGLE));
+		}
+		if (IsKeyPressed(KEY_TWO)) {
+			post(SimCommand::SPAWN_SHAPE, static_cast<int>(AsteroidShape::SQUARE));
+		}
+		if (IsKeyPressed(KEY_THREE)) {
+			post(SimCommand::SPAWN_SHAPE, static_cast<int>(AsteroidShape::PENTAGON));
+		}
+		if (IsKeyPressed(KEY_FOUR)) {
+			post(SimCommand::SPAWN_SHAPE, static_cast<int>(AsteroidShape::RANDOM));
+		}
+		if (IsKeyPressed(KEY_FIVE)) {
+			post(SimCommand::SPAWN_SHAPE, 6); // Chasing asteroid
+		}
 
-				player->Draw();
+		if (IsKeyPressed(KEY_F1)) {
+			showProfiler = !showProfiler;
+			post(SimCommand::PROFILER, 0);
+		}
+		if (IsKeyPressed(KEY_F2)) {
+			post(SimCommand::STRESS_MODE, 0);
+		}
+		if (IsKeyPressed(KEY_F3)) {
+			post(SimCommand::BRUTE_FORCE, 0);
+		}
+		if (IsKeyPressed(KEY_F4)) {
+			post(SimCommand::CHUNKS, 0);
+		}
+		if (IsKeyPressed(KEY_F6)) {
+			post(SimCommand::AUTOPILOT, 0);
+		}
+		if (IsKeyPressed(KEY_F7)) {
+			CycleRenderScale();
+		}
 
-				Renderer::Instance().End();
-			}
+		// Held keys only when they change, a fast window would otherwise fill the queue with copies
+		PlayerInput in = ReadKeyboard();
+		bool changed = in.move.x != posted.move.x || in.move.y != posted.move.y || in.fire != posted.fire;
+		if (changed || in.skill || in.switchWeapon || in.restart) {
+			SimMessage m;
+			m.input = in;
+			if (simThread.Post(m)) posted = in;
+			else link.OnInputDropped();
 		}
 	}
 
-private:
-	Application()
-	{
-		asteroids.reserve(1000);
-		projectiles.reserve(10'000);
-		score = 0;
-	};
-	int score;
-	std::vector<std::unique_ptr<Asteroid>> asteroids;
-	std::vector<Projectile> projectiles;
+	void DrawHud(const RenderSnapshot& snapshot, RenderCommandBuffer& out) const {
+		out.Text(RenderLayer::HUD, TextFormat("HP: %d", snapshot.hp),
+			{ 10, 10 }, 48, GREEN); // większy rozmiar czcionki
+
+		const char* weaponName = (snapshot.weapon == WeaponType::LASER) ? "LASER" : "BULLET";
+		out.Text(RenderLayer::HUD, TextFormat("Weapon: %s", weaponName),
+			{ 10, 70 }, 48, BLUE); // większy rozmiar czcionki i przesunięcie w dół
+
+		out.Text(RenderLayer::HUD, TextFormat("Score: %d", snapshot.score),
+			{ 10, 130 }, 48, YELLOW); // pozycja pod HP i Weapon, rozmiar i kolor możesz zmienić
 
-	AsteroidShape currentShape = AsteroidShape::RANDOM;
+		out.Text(RenderLayer::HUD, TextFormat("Overheat: %.1f", snapshot.overheat),
+			{ 10, 190 }, 48, RED); // wyświetlanie poziomu przegrzania
+	}
 
-	Texture2D backgroundTexture;
+	// F1 - the window thread's zones and counters from `firstRow` on (the simulation's
+	// come with its snapshot), with the render scale history underneath
+	void DrawProfiler(RenderCommandBuffer& out, int firstRow) const {
+		const OverlayLayout& o = C_OVERLAY;
+		Profiler::Instance().ForEachOverlayLine([&](const char* line, int row, bool isCounter) {
+			out.Text(RenderLayer::DEBUG, line, { o.x, o.Row(firstRow + row) }, o.fontSize, isCounter ? SKYBLUE : LIGHTGRAY);
+		});
+
+		const ResolutionScaler& scaler = Renderer::Instance().GetScaler();
+		float graphY = o.Row(firstRow + Profiler::Instance().OverlayRows() + 1);
+		out.Text(RenderLayer::DEBUG, TextFormat("Render scale %3.0f%%  %s", scaler.Scale() * 100.f,
+			scaler.GetFixed() > 0.f ? "(fixed, F7)" : "(auto, F7)"), { o.x, graphY }, o.fontSize, SKYBLUE);
+		graphY += o.fontSize + 4;
+		out.Rect(RenderLayer::DEBUG, { o.x, graphY, ResolutionScaler::HISTORY * 3.f, C_SCALE_GRAPH_HEIGHT }, Fade(BLACK, 0.5f));
+		int column = 0;
+		scaler.ForEachHistory([&](float scale) {
+			float h = C_SCALE_GRAPH_HEIGHT * scale;
+			out.Rect(RenderLayer::DEBUG, { o.x + column * 3.f, graphY + C_SCALE_GRAPH_HEIGHT - h, 2.f, h }, scale < 1.f ? ORANGE : SKYBLUE);
+			++column;
+		});
+	}
+
+	// F7 - automatic, then fixed 100%, 75% and 50%
+	void CycleRenderScale() {
+		static constexpr float STEPS[] = { 0.f, 1.f, 0.75f, 0.5f };
+		ResolutionScaler& scaler = Renderer::Instance().GetScaler();
+		size_t current = 0;
+		for (size_t i = 0; i < std::size(STEPS); ++i)
+			if (scaler.GetFixed() == STEPS[i]) current = i;
+		scaler.SetFixed(STEPS[(current + 1) % std::size(STEPS)]);
+	}
+
+	static void PrintRenderScale(std::FILE* out) {
+		float lo = 1.f, hi = 0.f, sum = 0.f;
+		int n = 0;
+		Renderer::Instance().GetScaler().ForEachHistory([&](float scale) {
+			lo = std::min(lo, scale);
+			hi = std::max(hi, scale);
+			sum += scale;
+			++n;
+		});
+		std::fprintf(out, "render scale over the last %d frames: min %.0f%%  avg %.0f%%  max %.0f%%\n",
+			n, lo * 100.f, n ? sum / n * 100.f : 0.f, hi * 100.f);
+	}
+
+	bool showProfiler = false;
+	RenderCommandBuffer frame;
+	ThreadLinkStats link;
+	PlayerInput posted; // last keyboard state the simulation thread accepted
+	double nextCapture = 0.0;
+	double captureInterval = 0.0;
 
 	static constexpr int C_WIDTH = 2560;
 	static constexpr int C_HEIGHT = 1400;
-	static constexpr size_t MAX_AST = 150;
-	static constexpr float C_SPAWN_MIN = 0.15f;
-	static constexpr float C_SPAWN_MAX = 0.5f;
-
-	static constexpr int C_MAX_ASTEROIDS = 1000;
-	static constexpr int C_MAX_PROJECTILES = 10'000;
+	static constexpr int C_WARMUP_FRAMES = 120;
+	static constexpr float C_BENCH_DT = 1.f / 60.f;
+	static constexpr float C_SCALE_GRAPH_HEIGHT = 60.f;
+	static constexpr OverlayLayout C_OVERLAY = { C_WIDTH - 900.f, 10.f, 20 };
 };
 
-int main() {
-	Application::Instance().Run();
-	return 0;
-}
\ No newline at end of file
+int main(int argc, char** argv) {
+	return Application::Instance().Run(ParseOptions(argc, argv));
+}
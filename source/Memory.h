@@ -0,0 +1,81 @@
+#pragma once
+// Allocation counters and steady-state regions. The executable routes global
+// operator new/delete through Memory::Allocate and Memory::Free (see Main.cpp);
+// other targets get the types but count nothing.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// --- MEMORY ---
+// Allocation counters fed by the replaced operator new in Main.cpp. Totals are
+// global, the thread_local ones let profiler zones attribute their own
+// allocations. Code inside a STEADY_STATE_REGION must not allocate once the
+// game is warmed up; such allocations are counted, or abort the game when
+// steady-state asserts are on (--assert-no-alloc).
+namespace Memory {
+	inline std::atomic<uint64_t> allocCount{ 0 };
+	inline std::atomic<uint64_t> allocBytes{ 0 };
+	inline std::atomic<int64_t> liveBytes{ 0 };
+	inline std::atomic<uint64_t> steadyStateViolations{ 0 };
+	inline std::atomic<bool> steadyStateArmed{ false };
+	inline bool steadyStateAsserts = false; // set once at startup
+
+	constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+	inline thread_local uint64_t threadAllocCount = 0;
+	inline thread_local uint64_t threadAllocBytes = 0;
+	inline thread_local const char* steadyRegion = nullptr;
+
+	inline void OnSteadyStateAllocation(std::size_t size) {
+		steadyStateViolations.fetch_add(1, std::memory_order_relaxed);
+		if (steadyStateAsserts) {
+			std::fprintf(stderr, "FATAL: allocation of %zu bytes inside steady-state region '%s'\n", size, steadyRegion);
+			std::fflush(stderr);
+			std::abort();
+		}
+	}
+
+	inline void* Allocate(std::size_t size) {
+		allocCount.fetch_add(1, std::memory_order_relaxed);
+		allocBytes.fetch_add(size, std::memory_order_relaxed);
+		++threadAllocCount;
+		threadAllocBytes += size;
+		if (steadyRegion && steadyStateArmed.load(std::memory_order_relaxed)) {
+			OnSteadyStateAllocation(size);
+		}
+		// A header in front of every block remembers its size so frees can update liveBytes
+		void* block = std::malloc(HEADER + size);
+		if (!block) throw std::bad_alloc();
+		*static_cast<std::size_t*>(block) = size;
+		liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+		return static_cast<char*>(block) + HEADER;
+	}
+
+	inline void Free(void* p) {
+		if (!p) return;
+		void* block = static_cast<char*>(p) - HEADER;
+		liveBytes.fetch_sub(static_cast<int64_t>(*static_cast<std::size_t*>(block)), std::memory_order_relaxed);
+		std::free(block);
+	}
+
+	class SteadyStateRegion {
+	public:
+		explicit SteadyStateRegion(const char* name) : previous(steadyRegion) {
+			steadyRegion = name;
+		}
+		~SteadyStateRegion() {
+			steadyRegion = previous;
+		}
+
+	private:
+		const char* previous;
+	};
+}
+
+#define STEADY_STATE_CONCAT_INNER(a, b) a##b
+#define STEADY_STATE_CONCAT(a, b) STEADY_STATE_CONCAT_INNER(a, b)
+#define STEADY_STATE_REGION(name) Memory::SteadyStateRegion STEADY_STATE_CONCAT(steadyRegion_, __LINE__)(name)
@@ -0,0 +1,182 @@
+// Accuracy and cost of the asteroid narrowphase. Random pairs whose bounding
+// circles overlap, half shot/ship circles against hulls, half hull pairs:
+//   - how many of them the outlines reject (hits the circle test alone would register on empty corners)
+//   - agreement of the exact test with a brute-force reference, and of the batched path with the scalar one
+//   - nanoseconds per pair for the circle test, the scalar and the batched exact test
+//   NarrowphaseBench.exe [--pairs N] [--reps N] [--seed N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Simulation.h"
+
+namespace {
+
+struct Shape {
+	AsteroidKind kind;
+	ShapePose pose;
+};
+
+struct Circle {
+	Vector2 center;
+	float radius;
+};
+
+// Outline of a placed hull in world space
+std::vector<Vector2> WorldOutline(const Shape& s) {
+	const HullOutline& h = ASTEROID_HULLS[static_cast<size_t>(s.kind)];
+	std::vector<Vector2> out(h.count);
+	for (int i = 0; i < h.count; ++i) {
+		Vector2 v = Vector2Scale(h.vertices[i], s.pose.radius);
+		out[i] = { s.pose.position.x + s.pose.cos * v.x - s.pose.sin * v.y, s.pose.position.y + s.pose.sin * v.x + s.pose.cos * v.y };
+	}
+	return out;
+}
+
+bool Inside(const std::vector<Vector2>& poly, Vector2 p) {
+	bool in = false;
+	for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+		if ((poly[i].y > p.y) != (poly[j].y > p.y) &&
+			p.x < (poly[j].x - poly[i].x) * (p.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x)
+			in = !in;
+	}
+	return in;
+}
+
+bool SegmentsCross(Vector2 a, Vector2 b, Vector2 c, Vector2 d) {
+	auto side = [](Vector2 o, Vector2 p, Vector2 q) { return (p.x - o.x) * (q.y - o.y) - (p.y - o.y) * (q.x - o.x); };
+	float d1 = side(c, d, a), d2 = side(c, d, b), d3 = side(a, b, c), d4 = side(a, b, d);
+	return ((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0));
+}
+
+// Reference without axes: edges cross, or one outline holds a corner of the other
+bool ReferenceHulls(const Shape& a, const Shape& b) {
+	std::vector<Vector2> pa = WorldOutline(a), pb = WorldOutline(b);
+	for (size_t i = 0; i < pa.size(); ++i)
+		for (size_t j = 0; j < pb.size(); ++j)
+			if (SegmentsCross(pa[i], pa[(i + 1) % pa.size()], pb[j], pb[(j + 1) % pb.size()])) return true;
+	return Inside(pa, pb[0]) || Inside(pb, pa[0]);
+}
+
+// Reference by sampling: the outline holds the center or a point of the rim, or the circle holds a corner
+bool ReferenceCircle(const Shape& s, const Circle& c) {
+	std::vector<Vector2> poly = WorldOutline(s);
+	if (Inside(poly, c.center)) return true;
+	for (Vector2 v : poly)
+		if (Vector2Distance(v, c.center) <= c.radius) return true;
+	for (int i = 0; i < 256; ++i) {
+		float a = 2.f * PI * i / 256.f;
+		if (Inside(poly, { c.center.x + cosf(a) * c.radius, c.center.y + sinf(a) * c.radius })) return true;
+	}
+	return false;
+}
+
+Shape RandomShape(Utils::Rng& rng, Vector2 at) {
+	float angle = rng.Float(0.f, 2.f * PI);
+	Shape s;
+	s.kind = static_cast<AsteroidKind>(rng.Int(0, static_cast<int>(ASTEROID_KIND_COUNT) - 1));
+	s.pose = { at, cosf(angle), sinf(angle), 16.f * static_cast<float>(1 << rng.Int(1, 2)) };
+	return s;
+}
+
+// Offset uniformly inside a disc of `reach`, so the bounding circles overlap
+Vector2 Within(Utils::Rng& rng, Vector2 from, float reach) {
+	float a = rng.Float(0.f, 2.f * PI);
+	float d = reach * sqrtf(rng.Float(0.f, 1.f));
+	return { from.x + cosf(a) * d, from.y + sinf(a) * d };
+}
+
+double Seconds(std::chrono::steady_clock::time_point since) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+	int pairs = 100'000;
+	int reps = 20;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--pairs") == 0 && i + 1 < argc) pairs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+	}
+
+	Utils::Rng rng(seed);
+	std::vector<Shape> hullA(pairs), hullB(pairs);
+	std::vector<Circle> circles(pairs);
+	for (int i = 0; i < pairs; ++i) {
+		hullA[i] = RandomShape(rng, { 0.f, 0.f });
+		Shape probe = RandomShape(rng, { 0.f, 0.f });
+		hullB[i] = RandomShape(rng, Within(rng, hullA[i].pose.position, hullA[i].pose.radius + probe.pose.radius));
+		hullB[i].pose.radius = probe.pose.radius;
+		if (Vector2Distance(hullA[i].pose.position, hullB[i].pose.position) >= hullA[i].pose.radius + hullB[i].pose.radius)
+			hullB[i].pose.position = hullA[i].pose.position;
+		float r = rng.Float(4.f, 40.f); // bullets up to the ship
+		circles[i] = { Within(rng, hullA[i].pose.position, hullA[i].pose.radius + r), r };
+	}
+
+	Narrowphase np;
+	np.Reserve(static_cast<size_t>(pairs) * 2);
+	for (int i = 0; i < pairs; ++i) {
+		np.AddCircle(hullA[i].kind, hullA[i].pose, circles[i].center, circles[i].radius, static_cast<uint32_t>(i));
+		np.AddHulls(hullA[i].kind, hullA[i].pose, hullB[i].kind, hullB[i].pose, static_cast<uint32_t>(pairs + i));
+	}
+
+	// Results of both paths, then the reference
+	std::vector<uint8_t> batched(2 * pairs), scalar(2 * pairs);
+	np.SetBatched(true);
+	np.Run([&](uint32_t tag, const Narrowphase::Contact&) { batched[tag] = 1; });
+	np.SetBatched(false);
+	np.Run([&](uint32_t tag, const Narrowphase::Contact&) { scalar[tag] = 1; });
+
+	long long circleHits = 0, hullHits = 0, pathMismatch = 0, circleWrong = 0, hullWrong = 0;
+	for (int i = 0; i < pairs; ++i) {
+		circleHits += batched[i];
+		hullHits += batched[pairs + i];
+		pathMismatch += (batched[i] != scalar[i]) + (batched[pairs + i] != scalar[pairs + i]);
+		circleWrong += batched[i] != static_cast<uint8_t>(ReferenceCircle(hullA[i], circles[i]));
+		hullWrong += batched[pairs + i] != static_cast<uint8_t>(ReferenceHulls(hullA[i], hullB[i]));
+	}
+
+	// Cost: the circle test over the same pairs, then both exact paths
+	volatile long long sink = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < reps; ++r) {
+		long long n = 0;
+		for (int i = 0; i < pairs; ++i) {
+			float reachA = hullA[i].pose.radius + circles[i].radius;
+			float reachB = hullA[i].pose.radius + hullB[i].pose.radius;
+			n += Vector2DistanceSqr(hullA[i].pose.position, circles[i].center) < reachA * reachA;
+			n += Vector2DistanceSqr(hullA[i].pose.position, hullB[i].pose.position) < reachB * reachB;
+		}
+		sink = sink + n;
+	}
+	double circleSec = Seconds(t0);
+
+	auto timeRun = [&](bool on) {
+		np.SetBatched(on);
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; ++r) {
+			long long n = 0;
+			np.Run([&n](uint32_t, const Narrowphase::Contact&) { ++n; });
+			sink = sink + n;
+		}
+		return Seconds(start);
+	};
+	double scalarSec = timeRun(false);
+	double batchedSec = timeRun(true);
+
+	double perPair = 1e9 / (2.0 * pairs * reps);
+	printf("%d circle-hull and %d hull-hull pairs with overlapping bounding circles, %d lanes\n", pairs, pairs, FloatLanes::COUNT);
+	printf("outlines touch: circle-hull %.1f%%, hull-hull %.1f%% - the rest were hits on empty corners\n",
+		100.0 * circleHits / pairs, 100.0 * hullHits / pairs);
+	printf("disagreements: batched vs scalar %lld, vs reference circle-hull %lld, hull-hull %lld\n",
+		pathMismatch, circleWrong, hullWrong);
+	printf("ns per pair: circle %.2f, exact scalar %.2f, exact batched %.2f (%.1fx)\n",
+		circleSec * perPair, scalarSec * perPair, batchedSec * perPair, scalarSec / batchedSec);
+	return 0;
+}
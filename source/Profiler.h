@@ -0,0 +1,221 @@
+#pragma once
+// Frame profiler: named zones with time and allocation counts, plus counters.
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "Memory.h"
+
+// --- PROFILER ---
+// Per-frame wall time and allocations of named zones. Zone names must be
+// string literals, they are matched by pointer first and by contents as a fallback.
+// Allocations are inclusive of nested zones and counted on the recording thread.
+// Every thread has its own Profiler, so the simulation and render threads each
+// see only their own zones and counters.
+class Profiler {
+public:
+	static Profiler& Instance() {
+		static thread_local Profiler inst;
+		return inst;
+	}
+
+	void Record(const char* name, double ms, uint64_t allocs, uint64_t bytes) {
+		Zone& z = Find(name);
+		z.frameMs += ms;
+		z.frameAllocs += allocs;
+		z.frameBytes += bytes;
+		++z.frameCalls;
+	}
+
+	// Folds the current frame into the history and starts a new one
+	void EndFrame() {
+		for (int i = 0; i < zoneCount; ++i) {
+			Zone& z = zones[i];
+			z.lastMs = z.frameMs;
+			z.lastCalls = z.frameCalls;
+			z.lastAllocs = z.frameAllocs;
+			z.avgMs += (z.frameMs - z.avgMs) * SMOOTHING;
+			z.totalMs += z.frameMs;
+			z.totalAllocs += z.frameAllocs;
+			z.totalBytes += z.frameBytes;
+			z.frameMs = 0.0;
+			z.frameCalls = 0;
+			z.frameAllocs = 0;
+			z.frameBytes = 0;
+		}
+
+		uint64_t allocs = Memory::threadAllocCount;
+		uint64_t bytes = Memory::threadAllocBytes;
+		lastFrameAllocs = allocs - frameStartAllocs;
+		totalAllocs += lastFrameAllocs;
+		totalBytes += bytes - frameStartBytes;
+		frameStartAllocs = allocs;
+		frameStartBytes = bytes;
+		++totalFrames;
+		SetCounter("Frame allocations", static_cast<long long>(lastFrameAllocs));
+	}
+
+	// Starts a new measurement window for PrintSummary
+	void ResetTotals() {
+		for (int i = 0; i < zoneCount; ++i) {
+			zones[i].totalMs = 0.0;
+			zones[i].totalAllocs = 0;
+			zones[i].totalBytes = 0;
+		}
+		totalFrames = 0;
+		totalAllocs = 0;
+		totalBytes = 0;
+	}
+
+	// Per-frame averages since the last ResetTotals, used by benchmark runs
+	void PrintSummary(std::FILE* out) const {
+		double frames = totalFrames ? static_cast<double>(totalFrames) : 1.0;
+		std::fprintf(out, "%-28s %12s %14s %14s\n", "zone", "ms/frame", "allocs/frame", "bytes/frame");
+		for (int i = 0; i < zoneCount; ++i) {
+			const Zone& z = zones[i];
+			std::fprintf(out, "%-28s %12.4f %14.2f %14.1f\n", z.name,
+				z.totalMs / frames, z.totalAllocs / frames, z.totalBytes / frames);
+		}
+		std::fprintf(out, "%-28s %12s %14.2f %14.1f\n", "<frame>", "", totalAllocs / frames, totalBytes / frames);
+		for (int i = 0; i < counterCount; ++i) {
+			std::fprintf(out, "%-28s %lld\n", counters[i].name, counters[i].value);
+		}
+		std::fprintf(out, "frames: %llu\n", static_cast<unsigned long long>(totalFrames));
+	}
+
+	// Counters are plain values shown next to the zones, overwritten every frame
+	void SetCounter(const char* name, long long value) {
+		for (int i = 0; i < counterCount; ++i) {
+			if (Matches(counters[i].name, name)) {
+				counters[i].value = value;
+				return;
+			}
+		}
+		if (counterCount == MAX_COUNTERS) return;
+		counters[counterCount++] = { name, value };
+	}
+
+	// Calls f(name, ms) for every zone with the time recorded so far this frame
+	template <typename F>
+	void ForEachZone(F&& f) const {
+		for (int i = 0; i < zoneCount; ++i)
+			f(zones[i].name, zones[i].frameMs);
+	}
+
+	double LastMs(const char* name) const {
+		for (int i = 0; i < zoneCount; ++i)
+			if (Matches(zones[i].name, name)) return zones[i].lastMs;
+		return 0.0;
+	}
+
+	// Overlay text, one call per line: f(text, row, isCounter). A blank row separates zones and counters.
+	// The text lives until f returns; formatted locally since TextFormat is not safe off the main thread.
+	template <typename F>
+	void ForEachOverlayLine(F&& f) const {
+		char line[OVERLAY_LINE];
+		for (int i = 0; i < zoneCount; ++i) {
+			const Zone& z = zones[i];
+			std::snprintf(line, sizeof(line), "%-28s %7.3f ms  avg %7.3f ms  x%d  %llu allocs", z.name, z.lastMs, z.avgMs, z.lastCalls,
+				static_cast<unsigned long long>(z.lastAllocs));
+			f(static_cast<const char*>(line), i, false);
+		}
+		for (int i = 0; i < counterCount; ++i) {
+			std::snprintf(line, sizeof(line), "%-28s %lld", counters[i].name, counters[i].value);
+			f(static_cast<const char*>(line), zoneCount + 1 + i, true);
+		}
+	}
+
+	// Rows ForEachOverlayLine produces, the separator included
+	int OverlayRows() const {
+		return counterCount > 0 ? zoneCount + 1 + counterCount : zoneCount;
+	}
+
+private:
+	Profiler() = default;
+
+	struct Zone {
+		const char* name = nullptr;
+		double frameMs = 0.0;
+		double lastMs = 0.0;
+		double avgMs = 0.0;
+		double totalMs = 0.0;
+		int frameCalls = 0;
+		int lastCalls = 0;
+		uint64_t frameAllocs = 0;
+		uint64_t frameBytes = 0;
+		uint64_t lastAllocs = 0;
+		uint64_t totalAllocs = 0;
+		uint64_t totalBytes = 0;
+	};
+
+	struct Counter {
+		const char* name = nullptr;
+		long long value = 0;
+	};
+
+	static bool Matches(const char* a, const char* b) {
+		return a == b || std::strcmp(a, b) == 0;
+	}
+
+	Zone& Find(const char* name) {
+		for (int i = 0; i < zoneCount; ++i)
+			if (Matches(zones[i].name, name)) return zones[i];
+		if (zoneCount == MAX_ZONES) return overflow;
+		zones[zoneCount].name = name;
+		return zones[zoneCount++];
+	}
+
+	static constexpr int MAX_ZONES = 32;
+	static constexpr int MAX_COUNTERS = 32;
+	static constexpr double SMOOTHING = 0.05;
+	static constexpr int OVERLAY_LINE = 128;
+
+	std::array<Zone, MAX_ZONES> zones{};
+	int zoneCount = 0;
+	std::array<Counter, MAX_COUNTERS> counters{};
+	int counterCount = 0;
+
+	uint64_t frameStartAllocs = 0;
+	uint64_t frameStartBytes = 0;
+	uint64_t lastFrameAllocs = 0;
+	uint64_t totalFrames = 0;
+	uint64_t totalAllocs = 0;
+	uint64_t totalBytes = 0;
+	Zone overflow{ "<overflow>" };
+};
+
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* zoneName)
+		: name(zoneName),
+		startAllocs(Memory::threadAllocCount),
+		startBytes(Memory::threadAllocBytes),
+		start(std::chrono::steady_clock::now()) {}
+	~ProfileZone() {
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+		Profiler::Instance().Record(name, ms.count(),
+			Memory::threadAllocCount - startAllocs, Memory::threadAllocBytes - startBytes);
+	}
+
+private:
+	const char* name;
+	uint64_t startAllocs;
+	uint64_t startBytes;
+	std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Builds that step many simulations on worker threads (the batch environment)
+// define PROFILER_DISABLED - a profiler per worker would only add noise.
+#if defined(PROFILER_DISABLED)
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)(value))
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) Profiler::Instance().SetCounter(name, value)
+#endif
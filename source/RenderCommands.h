@@ -0,0 +1,148 @@
+#pragma once
+// Texture slots and the recorded draw command buffer. No raylib calls happen
+// here, only its plain types are used.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include <raylib.h>
+
+// --- TEXTURES ---
+// Shared textures, loaded once in Renderer::Init and referenced by slot
+enum class TextureSlot : uint8_t { ASTEROID_TRIANGLE, ASTEROID_SQUARE, ASTEROID_PENTAGON, ASTEROID_CHASER, PLAYER_SHIP, BULLET, BACKGROUND, COUNT };
+
+inline constexpr const char* TEXTURE_FILES[] = {
+	"asteroid_triangle.png",
+	"asteroid_square.png",
+	"asteroid_pentagon.png",
+	"asteroid_chaser.png",
+	"spaceship2.png",
+	"bullet.png",
+	"background.png",
+};
+static_assert(std::size(TEXTURE_FILES) == static_cast<size_t>(TextureSlot::COUNT), "one file per TextureSlot");
+
+// --- RENDER COMMANDS ---
+// Game code records draws into a RenderCommandBuffer as plain data and the
+// Renderer submits the whole buffer once per frame. Recording never calls into
+// raylib, so a buffer can be filled on any thread and inspected without a GPU.
+// Layers are drawn in declaration order; BACKGROUND and everything from HUD on
+// are in screen space, the rest goes through the world camera. Layers before HUD
+// make up the scene, which may be rendered at reduced resolution.
+enum class RenderLayer : uint8_t { BACKGROUND, WORLD_DEBUG, PROJECTILES, ASTEROIDS, SHIPS, WORLD_UI, HUD, DEBUG, COUNT };
+
+inline constexpr bool IsScreenSpace(RenderLayer layer) {
+	return layer == RenderLayer::BACKGROUND || layer >= RenderLayer::HUD;
+}
+
+inline constexpr bool IsOverlay(RenderLayer layer) {
+	return layer >= RenderLayer::HUD;
+}
+
+enum class DrawOp : uint8_t { SPRITE, RECT, RECT_LINES, CIRCLE, TEXT };
+
+struct DrawCommand {
+	DrawOp op;
+	RenderLayer layer;
+	TextureSlot texture; // SPRITE
+	bool centered;       // TEXT: position.x is the middle of the line
+	Rectangle src;       // SPRITE, zero width means the whole texture
+	Rectangle dst;       // SPRITE, RECT, RECT_LINES
+	Vector2 position;    // SPRITE: origin, CIRCLE: center, TEXT: top left
+	float size;          // SPRITE: rotation, RECT_LINES: thickness, CIRCLE: radius, TEXT: font size
+	Color color;
+	uint32_t text;       // TEXT: offset into the buffer's text storage
+};
+
+class RenderCommandBuffer {
+public:
+	RenderCommandBuffer() {
+		commands.reserve(C_MAX_COMMANDS);
+		order.reserve(C_MAX_COMMANDS);
+		text.reserve(C_MAX_TEXT_BYTES);
+	}
+
+	void Clear() {
+		commands.clear();
+		order.clear();
+		text.clear();
+	}
+
+	void Sprite(RenderLayer layer, TextureSlot texture, Rectangle src, Rectangle dst, Vector2 origin, float rotation, Color tint) {
+		Push({ DrawOp::SPRITE, layer, texture, false, src, dst, origin, rotation, tint, 0 });
+	}
+
+	void Rect(RenderLayer layer, Rectangle r, Color color) {
+		Push({ DrawOp::RECT, layer, TextureSlot::COUNT, false, {}, r, {}, 0.f, color, 0 });
+	}
+
+	void RectLines(RenderLayer layer, Rectangle r, float thickness, Color color) {
+		Push({ DrawOp::RECT_LINES, layer, TextureSlot::COUNT, false, {}, r, {}, thickness, color, 0 });
+	}
+
+	void Circle(RenderLayer layer, Vector2 center, float radius, Color color) {
+		Push({ DrawOp::CIRCLE, layer, TextureSlot::COUNT, false, {}, {}, center, radius, color, 0 });
+	}
+
+	// The string is copied, TextFormat results can be passed directly
+	void Text(RenderLayer layer, const char* str, Vector2 pos, int fontSize, Color color, bool centered = false) {
+		uint32_t offset = static_cast<uint32_t>(text.size());
+		text.insert(text.end(), str, str + std::strlen(str) + 1);
+		Push({ DrawOp::TEXT, layer, TextureSlot::COUNT, centered, {}, {}, pos, (float)fontSize, color, offset });
+	}
+
+	// Records every command of `other` after the ones already here, in its recording order
+	void Append(const RenderCommandBuffer& other) {
+		uint32_t textBase = static_cast<uint32_t>(text.size());
+		text.insert(text.end(), other.text.begin(), other.text.end());
+		for (DrawCommand cmd : other.commands) {
+			if (cmd.op == DrawOp::TEXT) cmd.text += textBase;
+			Push(cmd);
+		}
+	}
+
+	// Orders the commands by layer, then by material (texture, shapes, text),
+	// then by recording order, so each layer changes GPU state as rarely as possible
+	void Sort() {
+		std::sort(order.begin(), order.end());
+	}
+
+	size_t Size() const {
+		return commands.size();
+	}
+
+	// i-th command in submission order, recording order until Sort is called
+	const DrawCommand& operator[](size_t i) const {
+		return commands[static_cast<uint32_t>(order[i])];
+	}
+
+	const char* TextOf(const DrawCommand& cmd) const {
+		return text.data() + cmd.text;
+	}
+
+	// Sort key material of a command: its texture slot for sprites, then shapes, then text
+	static uint8_t Material(const DrawCommand& cmd) {
+		switch (cmd.op) {
+		case DrawOp::SPRITE: return static_cast<uint8_t>(cmd.texture);
+		case DrawOp::TEXT: return static_cast<uint8_t>(TextureSlot::COUNT) + 1;
+		default: return static_cast<uint8_t>(TextureSlot::COUNT);
+		}
+	}
+
+private:
+	void Push(const DrawCommand& cmd) {
+		uint64_t seq = commands.size();
+		order.push_back(static_cast<uint64_t>(cmd.layer) << 40 | static_cast<uint64_t>(Material(cmd)) << 32 | seq);
+		commands.push_back(cmd);
+	}
+
+	static constexpr size_t C_MAX_COMMANDS = 16'384;
+	static constexpr size_t C_MAX_TEXT_BYTES = 64 * 1024;
+
+	std::vector<DrawCommand> commands; // recording order
+	std::vector<uint64_t> order;       // layer << 40 | material << 32 | index into commands
+	std::vector<char> text;
+};
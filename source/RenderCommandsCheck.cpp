@@ -0,0 +1,128 @@
+// Headless check of RenderCommandBuffer ordering. Random mixes of sprites,
+// shapes and text over every layer are recorded, part of them through Append,
+// then sorted:
+//   - before Sort commands come back in recording order
+//   - after Sort the order is strictly increasing in (layer, material, recording order)
+//   - every command is still there exactly once and text still reads the string it was recorded with
+// Exits with 1 on the first failing round.
+//   RenderCommandsCheck.exe [--rounds N] [--commands N] [--seed N]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "RenderCommands.h"
+
+namespace {
+
+// Every command carries its recording index in its color
+Color Tag(uint32_t seq) {
+	return { static_cast<unsigned char>(seq), static_cast<unsigned char>(seq >> 8), static_cast<unsigned char>(seq >> 16), 255 };
+}
+
+uint32_t Seq(const DrawCommand& cmd) {
+	return cmd.color.r | cmd.color.g << 8 | cmd.color.b << 16;
+}
+
+struct Recorder {
+	std::mt19937 rng;
+	std::vector<std::vector<char>> strings; // by recording index, empty for non-text
+
+	void Record(RenderCommandBuffer& out, uint32_t seq) {
+		RenderLayer layer = static_cast<RenderLayer>(rng() % static_cast<uint32_t>(RenderLayer::COUNT));
+		Color c = Tag(seq);
+		strings.emplace_back();
+		switch (static_cast<DrawOp>(rng() % 5)) {
+		case DrawOp::SPRITE: {
+			TextureSlot tex = static_cast<TextureSlot>(rng() % static_cast<uint32_t>(TextureSlot::COUNT));
+			out.Sprite(layer, tex, {}, { 0, 0, 8, 8 }, {}, 0.f, c);
+			break;
+		}
+		case DrawOp::RECT:
+			out.Rect(layer, { 0, 0, 8, 8 }, c);
+			break;
+		case DrawOp::RECT_LINES:
+			out.RectLines(layer, { 0, 0, 8, 8 }, 1.f, c);
+			break;
+		case DrawOp::CIRCLE:
+			out.Circle(layer, {}, 4.f, c);
+			break;
+		case DrawOp::TEXT: {
+			char str[32];
+			int len = std::snprintf(str, sizeof(str), "text %u", seq);
+			strings.back().assign(str, str + len + 1);
+			out.Text(layer, str, {}, 20, c, (rng() & 1) != 0);
+			break;
+		}
+		}
+	}
+};
+
+// Returns an empty string when the buffer passes, otherwise what went wrong
+const char* Verify(RenderCommandBuffer& buffer, const Recorder& rec) {
+	size_t n = buffer.Size();
+	if (n != rec.strings.size()) return "command count changed";
+	for (size_t i = 0; i < n; ++i) {
+		if (Seq(buffer[i]) != i) return "unsorted buffer is not in recording order";
+	}
+
+	buffer.Sort();
+	std::vector<uint8_t> seen(n, 0);
+	for (size_t i = 0; i < n; ++i) {
+		const DrawCommand& cmd = buffer[i];
+		uint32_t seq = Seq(cmd);
+		if (seq >= n || seen[seq]++) return "command lost or repeated by Sort";
+		if (i > 0) {
+			const DrawCommand& prev = buffer[i - 1];
+			auto key = [](const DrawCommand& c) { return std::make_tuple(c.layer, RenderCommandBuffer::Material(c), Seq(c)); };
+			if (!(key(prev) < key(cmd))) return "sorted order is not (layer, material, recording order)";
+		}
+		if (cmd.op == DrawOp::TEXT && std::strcmp(buffer.TextOf(cmd), rec.strings[seq].data()) != 0) return "text does not match its command";
+	}
+	return "";
+}
+
+}
+
+int main(int argc, char** argv) {
+	int rounds = 200;
+	int commands = 2000;
+	uint32_t seed = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) rounds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--commands") == 0 && i + 1 < argc) commands = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+	}
+
+	// Reused across rounds like the renderer's frame buffers, so Clear is covered too
+	RenderCommandBuffer buffer, appended;
+	Recorder rec{ std::mt19937(seed), {} };
+	long long total = 0;
+	for (int r = 0; r < rounds; ++r) {
+		buffer.Clear();
+		appended.Clear();
+		rec.strings.clear();
+
+		// The middle goes through Append, as a frame takes the snapshot's world
+		// between its background and its HUD
+		uint32_t n = static_cast<uint32_t>(commands);
+		uint32_t head = rec.rng() % (n + 1);
+		uint32_t tail = head + rec.rng() % (n - head + 1);
+		for (uint32_t i = 0; i < head; ++i) rec.Record(buffer, i);
+		for (uint32_t i = head; i < tail; ++i) rec.Record(appended, i);
+		buffer.Append(appended);
+		for (uint32_t i = tail; i < n; ++i) rec.Record(buffer, i);
+
+		const char* error = Verify(buffer, rec);
+		if (*error) {
+			std::printf("round %d (seed %u): %s\n", r, seed, error);
+			return 1;
+		}
+		total += static_cast<long long>(buffer.Size());
+	}
+	std::printf("render commands: %d rounds, %lld commands sorted by layer, material and recording order\n", rounds, total);
+	return 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+// Float lanes for batched math: AVX when the build enables it (/arch:AVX2),
+// SSE on any other x64 build, one plain float elsewhere. Code written against
+// FloatLanes runs COUNT independent items per operation on whichever it gets.
+
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX 1
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#endif
+
+// --- FLOAT LANES ---
+#if defined(SIMD_AVX)
+
+struct FloatLanes {
+	__m256 v;
+	static constexpr int COUNT = 8;
+	static FloatLanes Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+	static FloatLanes Splat(float f) { return { _mm256_set1_ps(f) }; }
+};
+struct MaskLanes {
+	__m256 v;
+};
+
+inline FloatLanes operator+(FloatLanes a, FloatLanes b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline FloatLanes operator-(FloatLanes a, FloatLanes b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline FloatLanes operator*(FloatLanes a, FloatLanes b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline FloatLanes Min(FloatLanes a, FloatLanes b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline MaskLanes operator<(FloatLanes a, FloatLanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline MaskLanes operator<=(FloatLanes a, FloatLanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline MaskLanes operator>(FloatLanes a, FloatLanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline MaskLanes operator|(MaskLanes a, MaskLanes b) { return { _mm256_or_ps(a.v, b.v) }; }
+// m ? a : b per lane
+inline FloatLanes Select(MaskLanes m, FloatLanes a, FloatLanes b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+// Bit i set when lane i is true
+inline uint32_t Bits(MaskLanes m) { return static_cast<uint32_t>(_mm256_movemask_ps(m.v)); }
+inline void Store(float* p, FloatLanes a) { _mm256_storeu_ps(p, a.v); }
+
+#elif defined(SIMD_SSE)
+
+struct FloatLanes {
+	__m128 v;
+	static constexpr int COUNT = 4;
+	static FloatLanes Load(const float* p) { return { _mm_loadu_ps(p) }; }
+	static FloatLanes Splat(float f) { return { _mm_set1_ps(f) }; }
+};
+struct MaskLanes {
+	__m128 v;
+};
+
+inline FloatLanes operator+(FloatLanes a, FloatLanes b) { return { _mm_add_ps(a.v, b.v) }; }
+inline FloatLanes operator-(FloatLanes a, FloatLanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline FloatLanes operator*(FloatLanes a, FloatLanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline FloatLanes Min(FloatLanes a, FloatLanes b) { return { _mm_min_ps(a.v, b.v) }; }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return { _mm_max_ps(a.v, b.v) }; }
+inline MaskLanes operator<(FloatLanes a, FloatLanes b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline MaskLanes operator<=(FloatLanes a, FloatLanes b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline MaskLanes operator>(FloatLanes a, FloatLanes b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline MaskLanes operator|(MaskLanes a, MaskLanes b) { return { _mm_or_ps(a.v, b.v) }; }
+// m ? a : b per lane (SSE2 has no blend)
+inline FloatLanes Select(MaskLanes m, FloatLanes a, FloatLanes b) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+// Bit i set when lane i is true
+inline uint32_t Bits(MaskLanes m) { return static_cast<uint32_t>(_mm_movemask_ps(m.v)); }
+inline void Store(float* p, FloatLanes a) { _mm_storeu_ps(p, a.v); }
+
+#else
+
+struct FloatLanes {
+	float v;
+	static constexpr int COUNT = 1;
+	static FloatLanes Load(const float* p) { return { *p }; }
+	static FloatLanes Splat(float f) { return { f }; }
+};
+struct MaskLanes {
+	bool v;
+};
+
+inline FloatLanes operator+(FloatLanes a, FloatLanes b) { return { a.v + b.v }; }
+inline FloatLanes operator-(FloatLanes a, FloatLanes b) { return { a.v - b.v }; }
+inline FloatLanes operator*(FloatLanes a, FloatLanes b) { return { a.v * b.v }; }
+inline FloatLanes Min(FloatLanes a, FloatLanes b) { return { a.v < b.v ? a.v : b.v }; }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return { a.v > b.v ? a.v : b.v }; }
+inline MaskLanes operator<(FloatLanes a, FloatLanes b) { return { a.v < b.v }; }
+inline MaskLanes operator<=(FloatLanes a, FloatLanes b) { return { a.v <= b.v }; }
+inline MaskLanes operator>(FloatLanes a, FloatLanes b) { return { a.v > b.v }; }
+inline MaskLanes operator|(MaskLanes a, MaskLanes b) { return { a.v || b.v }; }
+inline FloatLanes Select(MaskLanes m, FloatLanes a, FloatLanes b) { return { m.v ? a.v : b.v }; }
+inline uint32_t Bits(MaskLanes m) { return m.v ? 1u : 0u; }
+inline void Store(float* p, FloatLanes a) { *p = a.v; }
+
+#endif
@@ -0,0 +1,3041 @@
+#pragma once
+// Game state and rules: entities, broadphase, world chunks and the Simulation
+// that steps them. Nothing here opens a window or touches the GPU, so it is
+// shared by the game, headless runs and the batch environment library.
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include "Profiler.h"
+#include "RenderCommands.h"
+#include "Simd.h"
+
+// --- UTILS ---
+namespace Utils {
+	// splitmix64 - each simulation owns one, so a run replays exactly from its seed
+	class Rng {
+	public:
+		explicit Rng(uint64_t seed) : state(seed) {}
+
+		uint64_t Next() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		float Float(float min, float max) {
+			return min + static_cast<float>(Next() >> 40) * (1.f / 16777216.f) * (max - min);
+		}
+
+		// Inclusive on both ends, like GetRandomValue
+		int Int(int min, int max) {
+			return min + static_cast<int>(Next() % static_cast<uint64_t>(max - min + 1));
+		}
+
+	private:
+		uint64_t state;
+	};
+
+	inline bool CircleInRect(Vector2 p, float r, Rectangle rect) {
+		return p.x + r >= rect.x && p.x - r <= rect.x + rect.width &&
+			p.y + r >= rect.y && p.y - r <= rect.y + rect.height;
+	}
+}
+
+// --- ENEMY SCRIPTS ---
+// Enemy behavior is written as a coroutine:
+//
+//   EnemyScript Hunter(ScriptScheduler& s, uint32_t self, float speed) {
+//       for (;;) {
+//           co_await Chase(speed, 2.f);
+//           co_await Wait(0.5f);
+//           co_await Dash(s.DirToPlayer(self), 3.f * speed, 0.4f);
+//       }
+//   }
+//
+// Each awaited step writes a motion into the enemy's EnemyBrain and sleeps for
+// its duration. The entity follows that motion in its own Update every tick, so
+// the scheduler resumes a script only when its step ends - a few times a second
+// instead of every tick. Frames come from a per-scheduler FramePool.
+
+// Fixed-size blocks for coroutine frames. Grows a slab at a time and never
+// shrinks, so once warmed up spawning and killing scripts does not allocate.
+// Frames too big for a block go to the global heap.
+class FramePool {
+public:
+	static constexpr size_t BLOCK_SIZE = 512;
+	static constexpr size_t SLAB_BLOCKS = 64; // growth step past the reserved capacity
+
+	FramePool() = default;
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	void Reserve(size_t blocks) {
+		if (capacity < blocks) Grow(blocks - capacity);
+	}
+
+	void* Allocate(size_t size) {
+		if (size + HEADER > BLOCK_SIZE) {
+			auto* h = static_cast<Header*>(::operator new(size + HEADER));
+			h->pool = nullptr;
+			return reinterpret_cast<char*>(h) + HEADER;
+		}
+		if (!freeList) Grow(SLAB_BLOCKS);
+		Header* h = freeList;
+		freeList = h->next;
+		h->pool = this;
+		++used;
+		return reinterpret_cast<char*>(h) + HEADER;
+	}
+
+	static void Free(void* p) {
+		auto* h = reinterpret_cast<Header*>(static_cast<char*>(p) - HEADER);
+		FramePool* pool = h->pool;
+		if (!pool) {
+			::operator delete(h);
+			return;
+		}
+		h->next = pool->freeList;
+		pool->freeList = h;
+		--pool->used;
+	}
+
+	size_t Used() const {
+		return used;
+	}
+
+	size_t Capacity() const {
+		return capacity;
+	}
+
+private:
+	// Owning pool while the block is in use, next free block while it is not
+	union Header {
+		FramePool* pool;
+		Header* next;
+	};
+	static constexpr size_t HEADER = alignof(std::max_align_t);
+	static_assert(sizeof(Header) <= HEADER);
+
+	struct alignas(std::max_align_t) Block {
+		char bytes[BLOCK_SIZE];
+	};
+
+	void Grow(size_t blocks) {
+		slabs.push_back(std::make_unique<Block[]>(blocks));
+		Block* slab = slabs.back().get();
+		for (size_t i = blocks; i-- > 0;) {
+			auto* h = reinterpret_cast<Header*>(slab[i].bytes);
+			h->next = freeList;
+			freeList = h;
+		}
+		capacity += blocks;
+	}
+
+	std::vector<std::unique_ptr<Block[]>> slabs;
+	Header* freeList = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+};
+
+// What a scripted enemy does between resumes
+enum class EnemyMotion : uint8_t {
+	DRIFT,   // keeps the velocity it was given, bounces like any asteroid
+	MOVE_TO, // heads for `target` and stops there
+	CHASE,   // steers at the player
+	ORBIT,   // circles the player at `radius`, `turn` is +1 or -1
+};
+
+// The shared state between a script and its entity. The script sets the
+// motion, the entity's Update follows it and reports its position back.
+// Only what Update touches lives here, the scheduler's bookkeeping is separate.
+struct EnemyBrain {
+	EnemyMotion motion = EnemyMotion::DRIFT;
+	bool kick = false;     // DRIFT velocity not applied yet
+	float speed = 0.f;
+	Vector2 velocity{};    // DRIFT
+	Vector2 target{};      // MOVE_TO
+	float radius = 0.f;    // ORBIT
+	float turn = 1.f;      // ORBIT
+	uint8_t volley = 0;    // shots to fire at the player, the entity's owner clears it
+	float spread = 0.f;    // volley fan width in radians
+	Vector2 position{};
+
+	// Velocity for this tick, called from the entity's Update
+	Vector2 Steer(Vector2 pos, Vector2 vel, Vector2 playerPos, float dt) {
+		switch (motion) {
+		case EnemyMotion::DRIFT:
+			if (kick) {
+				kick = false;
+				return velocity;
+			}
+			return vel;
+		case EnemyMotion::MOVE_TO: {
+			Vector2 to = Vector2Subtract(target, pos);
+			float dist = Vector2Length(to);
+			if (dist < 1.f) return {};
+			return Vector2Scale(to, fminf(speed, dist / dt) / dist);
+		}
+		case EnemyMotion::CHASE:
+			return Vector2Scale(Vector2Normalize(Vector2Subtract(playerPos, pos)), speed);
+		case EnemyMotion::ORBIT: {
+			Vector2 out = Vector2Subtract(pos, playerPos);
+			float dist = Vector2Length(out);
+			Vector2 n = (dist > 0.f) ? Vector2Scale(out, 1.f / dist) : Vector2{ 1.f, 0.f };
+			Vector2 tangent = { -n.y * turn, n.x * turn };
+			float pull = Clamp((radius - dist) * 2.f, -speed, speed);
+			return Vector2Add(Vector2Scale(tangent, speed), Vector2Scale(n, pull));
+		}
+		}
+		return vel;
+	}
+};
+
+class ScriptScheduler;
+
+// Coroutine return type of every enemy script. The first two parameters must be
+// the scheduler and the brain slot - the frame is allocated from that scheduler's pool.
+struct EnemyScript {
+	struct promise_type {
+		template <typename... Args>
+		promise_type(ScriptScheduler& s, uint32_t slot, Args&...) : owner(&s), self(slot) {}
+
+		template <typename... Args>
+		static void* operator new(size_t size, ScriptScheduler& s, uint32_t, Args&...);
+		static void operator delete(void* p, size_t) {
+			FramePool::Free(p);
+		}
+
+		EnemyScript get_return_object() {
+			return { std::coroutine_handle<promise_type>::from_promise(*this) };
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; } // first runs on the scheduler's next tick
+		std::suspend_always final_suspend() noexcept { return {}; }   // destroyed by the scheduler
+		void return_void() {}
+		void unhandled_exception() { std::abort(); }
+
+		ScriptScheduler* owner;
+		uint32_t self;
+	};
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+// Resumes scripts whose current step has ended. Steps are kept in a min-heap
+// by wake time, so a tick costs O(due * log live) however many scripts exist.
+// Killed scripts leave their heap entry behind, the generation tells it is stale.
+class ScriptScheduler {
+public:
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	explicit ScriptScheduler(size_t capacity) {
+		brains.reserve(capacity);
+		slots.reserve(capacity);
+		freeSlots.reserve(capacity);
+		due.reserve(2 * capacity);
+		frames.Reserve(capacity);
+	}
+
+	ScriptScheduler(const ScriptScheduler&) = delete;
+	ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+
+	~ScriptScheduler() {
+		Clear();
+	}
+
+	// Starts script(*this, slot, args...) for an entity at `position`. It first
+	// runs on the next Run, until then the entity keeps its velocity.
+	template <typename Script, typename... Args>
+	uint32_t Spawn(Script script, uint64_t seed, Vector2 position, Args... args) {
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			slot = static_cast<uint32_t>(brains.size());
+			brains.emplace_back();
+			slots.emplace_back();
+		}
+		brains[slot] = EnemyBrain{};
+		brains[slot].position = position;
+		Slot& sl = slots[slot];
+		++sl.generation;
+		sl.rng = Utils::Rng(seed);
+		sl.live = true;
+		sl.suspended = false;
+		sl.missed = false;
+		sl.handle = script(*this, slot, args...).handle;
+		Schedule(slot, now);
+		++liveCount;
+		return slot;
+	}
+
+	// The entity was parked: its script stops resuming until Wake, so parked
+	// enemies cost nothing however many of them the world holds
+	void Suspend(uint32_t slot) {
+		Slot& sl = slots[slot];
+		if (!sl.live || sl.suspended) return;
+		sl.suspended = true;
+		++suspendedCount;
+	}
+
+	// The entity is active again; a step that ended while it was parked resumes on the next Run
+	void Wake(uint32_t slot) {
+		Slot& sl = slots[slot];
+		if (!sl.live || !sl.suspended) return;
+		sl.suspended = false;
+		--suspendedCount;
+		if (sl.missed) {
+			sl.missed = false;
+			Schedule(slot, now);
+		}
+	}
+
+	// The entity is gone - drops its script wherever it is suspended
+	void Kill(uint32_t slot) {
+		Slot& sl = slots[slot];
+		if (!sl.live) return;
+		if (sl.suspended) --suspendedCount;
+		sl.suspended = false;
+		sl.missed = false;
+		if (sl.handle) sl.handle.destroy();
+		sl.handle = {};
+		sl.live = false;
+		++sl.generation;
+		freeSlots.push_back(slot);
+		--liveCount;
+	}
+
+	void Clear() {
+		for (Slot& sl : slots) {
+			if (sl.handle) sl.handle.destroy();
+		}
+		brains.clear();
+		slots.clear();
+		freeSlots.clear();
+		due.clear();
+		liveCount = 0;
+		suspendedCount = 0;
+		now = 0.0; // a reset simulation starts its clock again, new scripts must be due from 0
+		resumes = 0;
+	}
+
+	// Resumes every script due at `time`, earliest first and by slot on ties
+	void Run(double time, Vector2 player) {
+		now = time;
+		playerPos = player;
+		resumes = 0;
+		while (!due.empty() && due.front().at <= now) {
+			std::pop_heap(due.begin(), due.end(), Later);
+			Due d = due.back();
+			due.pop_back();
+			Slot& sl = slots[d.slot];
+			if (!sl.live || sl.generation != d.generation || !sl.handle) continue;
+			if (sl.suspended) {
+				sl.missed = true;
+				continue;
+			}
+			++resumes;
+			sl.handle.resume();
+			// A finished script leaves the entity on its last motion
+			if (sl.handle.done()) {
+				sl.handle.destroy();
+				sl.handle = {};
+			}
+		}
+	}
+
+	// Wakes `slot` after `seconds`, always on a later Run than the current one
+	void Sleep(uint32_t slot, float seconds) {
+		Schedule(slot, now + std::max(static_cast<double>(seconds), 1e-6));
+	}
+
+	EnemyBrain& Brain(uint32_t slot) {
+		return brains[slot];
+	}
+
+	EnemyBrain* Brains() {
+		return brains.data();
+	}
+
+	Vector2 PlayerPos() const {
+		return playerPos;
+	}
+
+	float Random(uint32_t slot, float min, float max) {
+		return slots[slot].rng.Float(min, max);
+	}
+
+	Vector2 DirToPlayer(uint32_t slot) const {
+		return Vector2Normalize(Vector2Subtract(playerPos, brains[slot].position));
+	}
+
+	FramePool& Frames() {
+		return frames;
+	}
+
+	size_t Live() const {
+		return liveCount;
+	}
+
+	size_t Suspended() const {
+		return suspendedCount;
+	}
+
+	size_t LastResumes() const {
+		return resumes;
+	}
+
+private:
+	struct Slot {
+		Utils::Rng rng{ 0 };
+		std::coroutine_handle<> handle;
+		uint32_t generation = 0;
+		bool live = false;
+		bool suspended = false; // owner parked
+		bool missed = false;    // came due while suspended
+	};
+
+	struct Due {
+		double at;
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	static bool Later(const Due& a, const Due& b) {
+		return a.at != b.at ? a.at > b.at : a.slot > b.slot;
+	}
+
+	void Schedule(uint32_t slot, double at) {
+		due.push_back({ at, slot, slots[slot].generation });
+		std::push_heap(due.begin(), due.end(), Later);
+	}
+
+	FramePool frames;
+	std::vector<EnemyBrain> brains;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<Due> due;
+	double now = 0.0;
+	Vector2 playerPos{};
+	size_t liveCount = 0;
+	size_t suspendedCount = 0;
+	size_t resumes = 0;
+};
+
+template <typename... Args>
+void* EnemyScript::promise_type::operator new(size_t size, ScriptScheduler& s, uint32_t, Args&...) {
+	return s.Frames().Allocate(size);
+}
+
+// One motion step: sets the brain's motion when the script suspends and wakes it
+// `seconds` later. MOVE_TO with negative seconds sleeps for the travel time.
+struct MotionStep {
+	EnemyMotion motion;
+	float speed;
+	Vector2 vec;
+	float radius;
+	float turn;
+	float seconds;
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<EnemyScript::promise_type> h) const {
+		ScriptScheduler& s = *h.promise().owner;
+		uint32_t self = h.promise().self;
+		EnemyBrain& b = s.Brain(self);
+		b.motion = motion;
+		b.speed = speed;
+		b.radius = radius;
+		b.turn = turn;
+		float sleep = seconds;
+		if (motion == EnemyMotion::DRIFT) {
+			b.velocity = vec;
+			b.kick = true;
+		}
+		else if (motion == EnemyMotion::MOVE_TO) {
+			b.target = vec;
+			if (sleep < 0.f) sleep = (speed > 0.f) ? Vector2Distance(b.position, vec) / speed : 0.f;
+		}
+		s.Sleep(self, sleep);
+	}
+
+	void await_resume() const noexcept {}
+};
+
+// Asks the entity to fire `shots` in a fan at the player, keeping its motion
+struct FireStep {
+	uint8_t shots;
+	float spread;
+	float seconds;
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<EnemyScript::promise_type> h) const {
+		ScriptScheduler& s = *h.promise().owner;
+		EnemyBrain& b = s.Brain(h.promise().self);
+		b.volley = shots;
+		b.spread = spread;
+		s.Sleep(h.promise().self, seconds);
+	}
+
+	void await_resume() const noexcept {}
+};
+
+inline FireStep Volley(uint8_t shots, float spread, float seconds) {
+	return { shots, spread, seconds };
+}
+
+// Stops and waits
+inline MotionStep Wait(float seconds) {
+	return { EnemyMotion::DRIFT, 0.f, {}, 0.f, 1.f, seconds };
+}
+
+inline MotionStep MoveTo(Vector2 target, float speed) {
+	return { EnemyMotion::MOVE_TO, speed, target, 0.f, 1.f, -1.f };
+}
+
+inline MotionStep Chase(float speed, float seconds) {
+	return { EnemyMotion::CHASE, speed, {}, 0.f, 1.f, seconds };
+}
+
+// Straight line along `dir`, then keeps drifting at that velocity
+inline MotionStep Dash(Vector2 dir, float speed, float seconds) {
+	return { EnemyMotion::DRIFT, speed, Vector2Scale(dir, speed), 0.f, 1.f, seconds };
+}
+
+inline MotionStep Orbit(float radius, float speed, float turn, float seconds) {
+	return { EnemyMotion::ORBIT, speed, {}, radius, turn, seconds };
+}
+
+// --- TRANSFORM, PHYSICS, LIFETIME, RENDERABLE ---
+// Where a convex hull sits: its center, the cosine and sine of its rotation and
+// the radius its outline is scaled by
+struct ShapePose {
+	Vector2 position;
+	float cos;
+	float sin;
+	float radius;
+};
+
+struct TransformA {
+	Vector2 position{};
+	float rotation{};
+};
+
+struct Physics {
+	Vector2 velocity{};
+	float rotationSpeed{};
+};
+
+struct Renderable {
+	enum Size { SMALL = 1, MEDIUM = 2, LARGE = 4 } size = SMALL;
+};
+
+// --- COLLISION LAYERS ---
+// Every collider is on one layer and has a mask of the layers it can hit. A pair
+// is tested only when each side's mask has the other's layer, so e.g. enemy
+// shots never cost a distance test against asteroids.
+enum CollisionLayer : uint8_t {
+	LAYER_PLAYER = 1 << 0,
+	LAYER_PLAYER_SHOT = 1 << 1,
+	LAYER_ENEMY = 1 << 2,
+	LAYER_ENEMY_SHOT = 1 << 3,
+	LAYER_ASTEROID = 1 << 4,
+};
+constexpr int COLLISION_LAYER_COUNT = 5;
+
+struct CollisionFilter {
+	uint8_t layer;
+	uint8_t mask;
+
+	bool Accepts(CollisionFilter o) const {
+		return (mask & o.layer) != 0 && (o.mask & layer) != 0;
+	}
+};
+
+inline constexpr CollisionFilter FILTER_PLAYER = { LAYER_PLAYER, LAYER_ENEMY | LAYER_ENEMY_SHOT | LAYER_ASTEROID };
+inline constexpr CollisionFilter FILTER_PLAYER_SHOT = { LAYER_PLAYER_SHOT, LAYER_ENEMY | LAYER_ASTEROID };
+inline constexpr CollisionFilter FILTER_ENEMY = { LAYER_ENEMY, LAYER_PLAYER | LAYER_PLAYER_SHOT };
+inline constexpr CollisionFilter FILTER_ENEMY_SHOT = { LAYER_ENEMY_SHOT, LAYER_PLAYER };
+inline constexpr CollisionFilter FILTER_ASTEROID = { LAYER_ASTEROID, LAYER_PLAYER | LAYER_PLAYER_SHOT | LAYER_ASTEROID };
+
+// --- ASTEROID KINDS ---
+// Every asteroid kind is one row of ASTEROID_TRAITS. Update and Draw are
+// instantiated per kind, so behavior flags resolve at compile time and each
+// kind's batch runs without virtual calls.
+enum class AsteroidKind : uint8_t { TRIANGLE, SQUARE, PENTAGON, CHASER, COUNT };
+constexpr size_t ASTEROID_KIND_COUNT = static_cast<size_t>(AsteroidKind::COUNT);
+
+enum AsteroidBehavior : uint8_t {
+	BEHAVIOR_SPIN = 1 << 0,        // rotates with Physics::rotationSpeed
+	BEHAVIOR_FACE_PLAYER = 1 << 1, // sprite points at the player, rotated by faceOffsetDeg
+};
+
+using AsteroidScript = EnemyScript (*)(ScriptScheduler&, uint32_t, float);
+
+// Closes in, flanks, winds up and dashes through the player, then circles it
+// for a while. Every chaser rolls its own timings.
+static inline EnemyScript ChaserScript(ScriptScheduler& s, uint32_t self, float speed) {
+	for (;;) {
+		co_await Chase(speed, s.Random(self, 2.f, 4.f));
+
+		Vector2 player = s.PlayerPos();
+		Vector2 side = Vector2Subtract(s.Brain(self).position, player);
+		side = Vector2Scale(Vector2Normalize({ -side.y, side.x }), s.Random(self, 250.f, 400.f));
+		co_await MoveTo(Vector2Add(player, side), speed * 1.5f);
+
+		co_await Wait(s.Random(self, 0.3f, 0.6f));
+		co_await Dash(s.DirToPlayer(self), speed * 4.f, 0.35f);
+		co_await Orbit(s.Random(self, 220.f, 320.f), speed * 1.6f, s.Random(self, 0.f, 1.f) < 0.5f ? 1.f : -1.f,
+			s.Random(self, 1.5f, 3.f));
+	}
+}
+
+struct AsteroidTraits {
+	int baseDamage;
+	float radiusMultiplier; // radius = BASE_RADIUS * multiplier * size
+	TextureSlot texture;
+	uint8_t behavior;
+	AsteroidScript script;  // behavior script, nullptr for plain asteroids
+	float scriptSpeed;      // base speed handed to the script
+	float faceOffsetDeg;
+};
+
+inline constexpr AsteroidTraits ASTEROID_TRAITS[] = {
+	/* TRIANGLE */ { 5,  1.f, TextureSlot::ASTEROID_TRIANGLE, BEHAVIOR_SPIN, nullptr, 0.f, 0.f },
+	/* SQUARE   */ { 10, 1.f, TextureSlot::ASTEROID_SQUARE,   BEHAVIOR_SPIN, nullptr, 0.f, 0.f },
+	/* PENTAGON */ { 15, 1.f, TextureSlot::ASTEROID_PENTAGON, BEHAVIOR_SPIN, nullptr, 0.f, 0.f },
+	/* CHASER   */ { 20, 1.f, TextureSlot::ASTEROID_CHASER,   BEHAVIOR_FACE_PLAYER, ChaserScript, 110.f, 45.f },
+};
+static_assert(std::size(ASTEROID_TRAITS) == ASTEROID_KIND_COUNT, "one ASTEROID_TRAITS row per AsteroidKind");
+
+template <AsteroidKind K>
+inline constexpr AsteroidTraits TraitsOf = ASTEROID_TRAITS[static_cast<size_t>(K)];
+
+// Convex outline of each kind's sprite in units of its radius, vertices in order
+// around it. Traced from the opaque pixels of the texture that lie inside the
+// collision circle and cut down to at most C_HULL_MAX_VERTICES corners, so every
+// outline fits inside the circle and the circle test stays a safe early-out.
+constexpr int C_HULL_MAX_VERTICES = 8;
+
+struct HullOutline {
+	int count;
+	Vector2 vertices[C_HULL_MAX_VERTICES];
+};
+
+inline constexpr HullOutline ASTEROID_HULLS[] = {
+	/* TRIANGLE - round rock */ { 8, { { -0.875f, 0.211f }, { -0.754f, -0.500f }, { -0.082f, -0.875f }, { 0.465f, -0.734f },
+		{ 0.863f, -0.258f }, { 0.602f, 0.609f }, { 0.231f, 0.879f }, { -0.266f, 0.887f } } },
+	/* SQUARE   - flat saucer */ { 8, { { -0.914f, -0.027f }, { -0.180f, -0.523f }, { 0.160f, -0.531f }, { 0.914f, -0.027f },
+		{ 0.934f, 0.227f }, { 0.574f, 0.492f }, { -0.574f, 0.492f }, { -0.930f, 0.231f } } },
+	/* PENTAGON - space station */ { 8, { { -0.984f, -0.102f }, { -0.711f, -0.703f }, { 0.117f, -0.984f }, { 0.477f, -0.820f },
+		{ 0.930f, -0.086f }, { 0.773f, 0.531f }, { 0.023f, 0.945f }, { -0.656f, 0.719f } } },
+	/* CHASER   - fighter, nose up-right */ { 8, { { -0.914f, -0.402f }, { -0.176f, -0.984f }, { 0.641f, -0.766f }, { 0.766f, -0.641f },
+		{ 0.984f, 0.176f }, { 0.402f, 0.914f }, { -0.348f, 0.867f }, { -0.867f, 0.348f } } },
+};
+static_assert(std::size(ASTEROID_HULLS) == ASTEROID_KIND_COUNT, "one ASTEROID_HULLS row per AsteroidKind");
+
+// Calls f(std::integral_constant<AsteroidKind, K>) for every kind in declaration order
+template <typename F, size_t... I>
+static inline void ForEachAsteroidKindImpl(F&& f, std::index_sequence<I...>) {
+	(f(std::integral_constant<AsteroidKind, static_cast<AsteroidKind>(I)>{}), ...);
+}
+
+template <typename F>
+static inline void ForEachAsteroidKind(F&& f) {
+	ForEachAsteroidKindImpl(f, std::make_index_sequence<ASTEROID_KIND_COUNT>{});
+}
+
+// --- ASTEROID ---
+class Asteroid {
+public:
+	// Spawns just outside `view`, heading into it
+	Asteroid(AsteroidKind k, Utils::Rng& rng, Rectangle view) : kind(k) {
+		init(rng, view);
+	}
+
+	// Asteroids live until they are shot and bounce off the world edges.
+	// Scripted kinds take their velocity from their brain in `brains`.
+	template <AsteroidKind K>
+	void Update(float dt, Vector2 playerPos, float worldW, float worldH, EnemyBrain* brains) {
+		constexpr AsteroidTraits traits = TraitsOf<K>;
+		if constexpr (traits.script != nullptr) {
+			if (script != ScriptScheduler::NONE) {
+				physics.velocity = brains[script].Steer(transform.position, physics.velocity, playerPos, dt);
+			}
+		}
+		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
+		if constexpr ((traits.behavior & BEHAVIOR_SPIN) != 0) {
+			transform.rotation += physics.rotationSpeed * dt;
+		}
+
+		if ((transform.position.x < radius && physics.velocity.x < 0.f) ||
+			(transform.position.x > worldW - radius && physics.velocity.x > 0.f))
+			physics.velocity.x = -physics.velocity.x;
+		if ((transform.position.y < radius && physics.velocity.y < 0.f) ||
+			(transform.position.y > worldH - radius && physics.velocity.y > 0.f))
+			physics.velocity.y = -physics.velocity.y;
+
+		if constexpr (traits.script != nullptr) {
+			if (script != ScriptScheduler::NONE) brains[script].position = transform.position;
+		}
+	}
+
+	// Same as Update<K> for a kind only known at run time
+	void UpdateAny(float dt, Vector2 playerPos, float worldW, float worldH, EnemyBrain* brains) {
+		ForEachAsteroidKind([&](auto k) {
+			constexpr AsteroidKind K = decltype(k)::value;
+			if (kind == K) Update<K>(dt, playerPos, worldW, worldH, brains);
+		});
+	}
+
+	// Moves the asteroid to pos with a random heading, for populating the world
+	void Place(Utils::Rng& rng, Vector2 pos) {
+		transform.position = pos;
+		float ang = rng.Float(0, 2 * PI);
+		physics.velocity = Vector2Scale({ cosf(ang), sinf(ang) }, rng.Float(SPEED_MIN, SPEED_MAX));
+	}
+
+	// Sprite rotation in degrees; kinds that face the player work it out from playerPos
+	template <AsteroidKind K>
+	float Angle(Vector2 playerPos) const {
+		constexpr AsteroidTraits traits = TraitsOf<K>;
+		if constexpr ((traits.behavior & BEHAVIOR_FACE_PLAYER) != 0) {
+			float angleToPlayer = atan2f(playerPos.y - transform.position.y, playerPos.x - transform.position.x);
+			return angleToPlayer * RAD2DEG + traits.faceOffsetDeg;
+		}
+		return transform.rotation;
+	}
+
+	float GetAngle(Vector2 playerPos) const {
+		float angle = 0.f;
+		ForEachAsteroidKind([&](auto k) {
+			constexpr AsteroidKind K = decltype(k)::value;
+			if (kind == K) angle = Angle<K>(playerPos);
+		});
+		return angle;
+	}
+
+	// Where the narrowphase places this kind's hull: the sprite's center, rotation and radius
+	ShapePose GetPose(Vector2 playerPos) const {
+		float angle = GetAngle(playerPos) * DEG2RAD;
+		return { transform.position, cosf(angle), sinf(angle), radius };
+	}
+
+	template <AsteroidKind K>
+	void Draw(RenderCommandBuffer& out, Vector2 playerPos) const {
+		constexpr AsteroidTraits traits = TraitsOf<K>;
+		float angle = Angle<K>(playerPos);
+
+		// Asteroid textures are square, the sprite spans the collision circle
+		Rectangle dst = {
+			transform.position.x,
+			transform.position.y,
+			radius * 2.0f,
+			radius * 2.0f
+		};
+		Vector2 origin = { radius, radius };
+		out.Sprite(RenderLayer::ASTEROIDS, traits.texture, {}, dst, origin, angle, WHITE);
+	}
+
+	AsteroidKind GetKind() const {
+		return kind;
+	}
+
+	CollisionFilter GetFilter() const {
+		return FILTER_ASTEROID;
+	}
+
+	// Brain slot in the simulation's ScriptScheduler, NONE for unscripted asteroids
+	uint32_t GetScript() const {
+		return script;
+	}
+
+	void SetScript(uint32_t slot) {
+		script = slot;
+	}
+
+	Vector2 GetPosition() const {
+		return transform.position;
+	}
+
+	Vector2 GetVelocity() const {
+		return physics.velocity;
+	}
+
+	float GetRadius() const {
+		return radius;
+	}
+
+	int GetDamage() const {
+		return damage;
+	}
+
+	int GetSize() const {
+		return static_cast<int>(render.size);
+	}
+
+	float GetMass() const {
+		return static_cast<float>(render.size);
+	}
+
+	// Elastic bounce between two touching asteroids, mass weighted by size. `n`
+	// points from a to b and `overlap` is how far the outlines interpenetrate along
+	// it; the overlap is split by inverse mass so heavier asteroids get pushed less.
+	static void Bounce(Asteroid& a, Asteroid& b, Vector2 n, float overlap) {
+		float invA = 1.f / a.GetMass();
+		float invB = 1.f / b.GetMass();
+		float invSum = invA + invB;
+
+		a.transform.position = Vector2Subtract(a.transform.position, Vector2Scale(n, overlap * invA / invSum));
+		b.transform.position = Vector2Add(b.transform.position, Vector2Scale(n, overlap * invB / invSum));
+
+		float approach = Vector2DotProduct(Vector2Subtract(b.physics.velocity, a.physics.velocity), n);
+		if (approach >= 0.f) return; // already separating
+
+		float j = -2.f * approach / invSum;
+		a.physics.velocity = Vector2Subtract(a.physics.velocity, Vector2Scale(n, j * invA));
+		b.physics.velocity = Vector2Add(b.physics.velocity, Vector2Scale(n, j * invB));
+	}
+
+private:
+	void init(Utils::Rng& rng, Rectangle view) {
+		const AsteroidTraits& traits = ASTEROID_TRAITS[static_cast<size_t>(kind)];
+
+		// Choose size
+		render.size = static_cast<Renderable::Size>(1 << rng.Int(1, 2));
+		radius = BASE_RADIUS * traits.radiusMultiplier * (float)render.size;
+		damage = traits.baseDamage * static_cast<int>(render.size);
+
+		// Spawn at random edge
+		float left = view.x;
+		float top = view.y;
+		float right = view.x + view.width;
+		float bottom = view.y + view.height;
+		switch (rng.Int(0, 3)) {
+		case 0:
+			transform.position = { rng.Float(left, right), top - radius };
+			break;
+		case 1:
+			transform.position = { right + radius, rng.Float(top, bottom) };
+			break;
+		case 2:
+			transform.position = { rng.Float(left, right), bottom + radius };
+			break;
+		default:
+			transform.position = { left - radius, rng.Float(top, bottom) };
+			break;
+		}
+
+		// Aim towards center with jitter
+		float maxOff = fminf(view.width, view.height) * 0.2f;
+		float ang = rng.Float(0, 2 * PI);
+		float rad = rng.Float(0, maxOff);
+		Vector2 center = {
+										 left + view.width * 0.5f + cosf(ang) * rad,
+										 top + view.height * 0.5f + sinf(ang) * rad
+		};
+
+		Vector2 dir = Vector2Normalize(Vector2Subtract(center, transform.position));
+		physics.velocity = Vector2Scale(dir, rng.Float(SPEED_MIN, SPEED_MAX));
+		physics.rotationSpeed = rng.Float(ROT_MIN, ROT_MAX);
+
+		transform.rotation = rng.Float(0, 360);
+	}
+
+	TransformA transform;
+	Physics    physics;
+	Renderable render;
+
+	AsteroidKind kind;
+	float radius = 0.f;
+	int damage = 0;
+	uint32_t script = ScriptScheduler::NONE;
+
+	static constexpr float BASE_RADIUS = 16.f;
+	static constexpr float LIFE = 10.f;
+	static constexpr float SPEED_MIN = 125.f;
+	static constexpr float SPEED_MAX = 250.f;
+	static constexpr float ROT_MIN = 50.f;
+	static constexpr float ROT_MAX = 240.f;
+};
+
+// Shape selector
+enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, RANDOM = 0 };
+
+// Factory
+static inline Asteroid MakeAsteroid(Utils::Rng& rng, Rectangle view, AsteroidShape shape) {
+	switch (shape) {
+	case AsteroidShape::TRIANGLE:
+		return Asteroid(AsteroidKind::TRIANGLE, rng, view);
+	case AsteroidShape::SQUARE:
+		return Asteroid(AsteroidKind::SQUARE, rng, view);
+	case AsteroidShape::PENTAGON:
+		return Asteroid(AsteroidKind::PENTAGON, rng, view);
+	case AsteroidShape::RANDOM: {
+		
+		int r = rng.Int(0, 9);
+		if (r < 1) // 0,1 -> chasing (20%)
+			return Asteroid(AsteroidKind::CHASER, rng, view);
+		else {
+			int type = rng.Int(0, 2);
+			switch (type) {
+			case 0: return Asteroid(AsteroidKind::TRIANGLE, rng, view);
+			case 1: return Asteroid(AsteroidKind::SQUARE, rng, view);
+			default: return Asteroid(AsteroidKind::PENTAGON, rng, view);
+			}
+		}
+	}
+	default:
+		return Asteroid(AsteroidKind::CHASER, rng, view);
+	}
+}
+
+// --- PROJECTILE HIERARCHY ---
+enum class WeaponType { LASER, BULLET, COUNT };
+class Projectile {
+public:
+	Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt, bool textured = false, CollisionFilter f = FILTER_PLAYER_SHOT)
+		: hasTexture(textured), filter(f)
+	{
+		transform.position = pos;
+		physics.velocity = vel;
+		baseDamage = dmg;
+		type = wt;
+	}
+
+	// Returns true once the projectile has left `bounds`
+	bool Update(float dt, Rectangle bounds) {
+		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
+
+		if (transform.position.x < bounds.x ||
+			transform.position.x > bounds.x + bounds.width ||
+			transform.position.y < bounds.y ||
+			transform.position.y > bounds.y + bounds.height)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	void Draw(RenderCommandBuffer& out) const {
+		if (hasTexture) {
+			float scale = 0.2f; // Ustaw skalę według potrzeb
+			float size = BULLET_SPRITE_SIZE * scale;
+			Rectangle dst = { transform.position.x - size * 0.5f, transform.position.y - size * 0.5f, size, size };
+			out.Sprite(RenderLayer::PROJECTILES, TextureSlot::BULLET, {}, dst, { 0, 0 }, 0.0f, WHITE);
+		}
+		else if (filter.layer == LAYER_ENEMY_SHOT) {
+			out.Circle(RenderLayer::PROJECTILES, transform.position, 6.f, ORANGE);
+		}
+		else if (type == WeaponType::BULLET) {
+			out.Circle(RenderLayer::PROJECTILES, transform.position, 5.f, WHITE);
+		}
+		else {
+			static constexpr float LASER_LENGTH = 30.f;
+			Rectangle lr = { transform.position.x - 2.f, transform.position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
+			out.Rect(RenderLayer::PROJECTILES, lr, RED);
+		}
+	}
+
+	Vector2 GetPosition() const {
+		return transform.position;
+	}
+
+	Vector2 GetVelocity() const {
+		return physics.velocity;
+	}
+
+	float GetRadius() const {
+		return (type == WeaponType::BULLET) ? 5.f : 2.f;
+	}
+
+	int GetDamage() const {
+		return baseDamage;
+	}
+
+	CollisionFilter GetFilter() const {
+		return filter;
+	}
+
+private:
+	TransformA transform;
+	Physics    physics;
+	int        baseDamage;
+	WeaponType type;
+	bool       hasTexture;
+	CollisionFilter filter;
+
+	static constexpr float BULLET_SPRITE_SIZE = 512.f; // bullet.png
+};
+
+inline static Projectile MakeProjectile(WeaponType wt,
+	const Vector2 pos,
+	float speed)
+{
+	Vector2 vel{ 0, -speed };
+	if (wt == WeaponType::LASER) {
+		return Projectile(pos, vel, 20, wt);
+	}
+	else {
+		return Projectile(pos, vel, 10, wt);
+	}
+}
+
+// Fired by enemy gunships, hurts only the player
+inline static Projectile MakeEnemyShot(Vector2 pos, Vector2 vel) {
+	return Projectile(pos, vel, 6, WeaponType::BULLET, false, FILTER_ENEMY_SHOT);
+}
+
+// --- PLAYER INPUT ---
+// What the keyboard (or the autopilot) asks the player ship to do this tick
+struct PlayerInput {
+	Vector2 move{};            // -1..1 per axis
+	bool fire = false;
+	bool skill = false;        // E - flame wave while overheated
+	bool switchWeapon = false;
+	bool restart = false;
+};
+
+// --- SHIP HIERARCHY ---
+class Ship {
+public:
+	Ship(int screenW, int screenH) {
+		transform.position = {
+												 screenW * 0.5f,
+												 screenH * 0.5f
+		};
+		hp = 100;
+		speed = 400.f;
+		alive = true;
+
+		// per-weapon fire rate & spacing
+		fireRateLaser = 18.f; // shots/sec
+		fireRateBullet = 22.f;
+		spacingLaser = 40.f; // px between lasers
+		spacingBullet = 20.f;
+	}
+	virtual ~Ship() = default;
+	virtual void Update(float dt) = 0;
+	// `time` is the simulation clock, blinking follows it rather than the wall clock
+	virtual void Draw(RenderCommandBuffer& out, double time) const = 0;
+
+	void TakeDamage(int dmg) {
+		if (!alive) return;
+		hp -= dmg;
+		if (hp <= 0) alive = false;
+	}
+
+	bool IsAlive() const {
+		return alive;
+	}
+
+	Vector2 GetPosition() const {
+		return transform.position;
+	}
+
+	virtual float GetRadius() const = 0;
+	virtual CollisionFilter GetFilter() const = 0;
+
+	int GetHP() const {
+		return hp;
+	}
+
+	void KeepInside(float w, float h) {
+		transform.position.x = Clamp(transform.position.x, 0.f, w);
+		transform.position.y = Clamp(transform.position.y, 0.f, h);
+	}
+
+	float GetFireRate(WeaponType wt) const {
+		return (wt == WeaponType::LASER) ? fireRateLaser : fireRateBullet;
+	}
+
+	float GetSpacing(WeaponType wt) const {
+		return (wt == WeaponType::LASER) ? spacingLaser : spacingBullet;
+	}
+
+protected:
+	TransformA transform;
+	int        hp;
+	float      speed;
+	bool       alive;
+	float      fireRateLaser;
+	float      fireRateBullet;
+	float      spacingLaser;
+	float      spacingBullet;
+};
+
+class PlayerShip :public Ship {
+public:
+	// --- OVERHEAT ---
+	float overheat = 0.0f;
+	float overheatCooldown = 0.0f;
+	bool overheated = false;
+	static constexpr float OVERHEAT_MAX = 100.0f;
+	static constexpr float OVERHEAT_PER_SHOT = 3.0f; // ile za 1 strzał
+	static constexpr float OVERHEAT_COOLDOWN_RATE = 30.0f; // ile schodzi na sekundę
+	static constexpr float OVERHEAT_COOLDOWN_DELAY = 1.0f; // po strzale, ile czeka zanim zacznie chłodzić
+	bool overheatSkillUsed = false;
+
+	PlayerShip(int w, int h) : Ship(w, h) {}
+
+	void SetInput(const PlayerInput& in) {
+		input = in;
+	}
+
+	void Update(float dt) override {
+		if (alive) {
+			transform.position.x += Clamp(input.move.x, -1.f, 1.f) * speed * dt;
+			transform.position.y += Clamp(input.move.y, -1.f, 1.f) * speed * dt;
+		}
+		else {
+			transform.position.y += speed * dt;
+		}
+		// Chłodzenie broni
+		if (overheat > 0.0f) {
+			if (overheatCooldown > 0.0f)
+				overheatCooldown -= dt;
+			else
+				overheat = std::max(0.0f, overheat - OVERHEAT_COOLDOWN_RATE * dt);
+		}
+		if (overheat >= OVERHEAT_MAX) {
+			overheated = true;
+			overheat = OVERHEAT_MAX;
+		}
+		if (overheated && overheat <= 0.0f) {
+			overheated = false;
+			overheatSkillUsed = false;
+		}
+	}
+
+	void Draw(RenderCommandBuffer& out, double time) const override {
+		if (!alive && fmodf(time, 0.4f) > 0.2f) return;
+		float spriteSize = SPRITE_SIZE * SCALE;
+		Rectangle dst = {
+										 transform.position.x - spriteSize * 0.5f,
+										 transform.position.y - spriteSize * 0.5f,
+										 spriteSize, spriteSize
+		};
+		out.Sprite(RenderLayer::SHIPS, TextureSlot::PLAYER_SHIP, {}, dst, { 0, 0 }, 0.0f, WHITE);
+
+		// --- HEALTHBAR ---
+		// Parametry paska
+		float barWidth = 60.0f;
+		float barHeight = 8.0f;
+		float barOffsetY = spriteSize * 0.5f + 12.0f; // odległość pod statkiem
+
+		float hpPercent = (float)hp / 100.0f;
+		float filledWidth = barWidth * hpPercent;
+
+		Vector2 barPos = {
+			transform.position.x - barWidth * 0.5f,
+			transform.position.y + barOffsetY
+		};
+
+		// Tło paska (szary)
+		out.Rect(RenderLayer::WORLD_UI, { barPos.x, barPos.y, barWidth, barHeight }, DARKGRAY);
+		// Wypełnienie (zielony/czerwony)
+		Color fillColor = (hpPercent > 0.5f) ? GREEN : (hpPercent > 0.2f ? ORANGE : RED);
+		out.Rect(RenderLayer::WORLD_UI, { barPos.x, barPos.y, filledWidth, barHeight }, fillColor);
+		// Ramka
+		out.RectLines(RenderLayer::WORLD_UI, { barPos.x, barPos.y, barWidth, barHeight }, 1.f, BLACK);
+
+
+		// --- OVERHEAT BAR ---
+		float barWidth1 = 16.0f;
+		float barHeight1 = 80.0f;
+		float barOffsetX1 = spriteSize * 0.5f + 16.0f;
+		float barOffsetY1 = 0.0f;
+
+		Vector2 barPos1 = {
+			transform.position.x + barOffsetX1,
+			transform.position.y - barHeight1 * 0.5f + barOffsetY1
+		};
+
+		// Tło paska (ciemny szary)
+		out.Rect(RenderLayer::WORLD_UI, { barPos1.x, barPos1.y, barWidth1, barHeight1 }, DARKGRAY);
+
+		// Wypełnienie (czerwony)
+		float fillHeight1 = barHeight1 * GetOverheatPercent();
+		Vector2 fillPos1 = { barPos1.x, barPos1.y + barHeight1 - fillHeight1 };
+		out.Rect(RenderLayer::WORLD_UI, { fillPos1.x, fillPos1.y, barWidth1, fillHeight1 }, (overheated ? ORANGE : RED));
+
+		// Ramka
+		out.RectLines(RenderLayer::WORLD_UI, { barPos1.x, barPos1.y, barWidth1, barHeight1 }, 1.f, BLACK);
+
+		// --- OVERHEATED TEXT ---
+		if (overheated && fmodf(time, 0.6f) < 0.3f) {
+			const char* txt = "OVERHEATED!";
+			int fontSize = 32;
+			Vector2 textPos = {
+				transform.position.x,
+				transform.position.y + spriteSize * 0.5f + 40.0f // 40px pod statkiem
+			};
+			out.Text(RenderLayer::WORLD_UI, txt, textPos, fontSize, ORANGE, true);
+		}
+		// --- PRESS E TEXT ---
+		if (overheated && fmodf(time, 0.8f) < 0.4f && !overheatSkillUsed) {
+			const char* txt = "PRESS E";
+			int fontSize = 28;
+			Vector2 textPos = {
+				transform.position.x,
+				transform.position.y + spriteSize * 0.5f + 80.0f // pod napisem OVERHEATED!
+			};
+			out.Text(RenderLayer::WORLD_UI, txt, textPos, fontSize, YELLOW, true);
+		}
+
+	}
+
+	// Fixed so the simulation does not depend on loaded textures (spaceship2.png is 512 px wide)
+	float GetRadius() const override {
+		return (SPRITE_SIZE * SCALE) * 0.5f;
+	}
+
+	CollisionFilter GetFilter() const override {
+		return FILTER_PLAYER;
+	}
+
+	bool CanShoot() const { return !overheated; }
+	float GetOverheatPercent() const { return overheat / OVERHEAT_MAX; }
+	bool IsOverheated() const { return overheated; }
+
+private:
+	static constexpr float SCALE = 0.25f;
+	static constexpr float SPRITE_SIZE = 512.f;
+
+	PlayerInput input;
+};
+
+// --- ENEMY SHIPS ---
+// Gunships keep their distance and shoot back. Movement and firing come from
+// GunshipScript through the ship's EnemyBrain, like the scripted asteroids.
+class EnemyShip :public Ship {
+public:
+	EnemyShip(Vector2 pos, uint32_t brain) : Ship(0, 0), script(brain) {
+		transform.position = pos;
+		hp = MAX_HP;
+	}
+
+	// Takes this tick's velocity from the brain and turns toward the player
+	void Follow(EnemyBrain& brain, Vector2 playerPos, float dt) {
+		velocity = brain.Steer(transform.position, velocity, playerPos, dt);
+		facing = atan2f(playerPos.y - transform.position.y, playerPos.x - transform.position.x) * RAD2DEG;
+	}
+
+	void Update(float dt) override {
+		transform.position = Vector2Add(transform.position, Vector2Scale(velocity, dt));
+	}
+
+	void Draw(RenderCommandBuffer& out, double) const override {
+		float size = SPRITE_SIZE * SCALE;
+		Rectangle dst = { transform.position.x, transform.position.y, size, size };
+		// The player sprite points up, +90 turns it toward `facing`
+		out.Sprite(RenderLayer::SHIPS, TextureSlot::PLAYER_SHIP, {}, dst, { size * 0.5f, size * 0.5f }, facing + 90.f, RED);
+
+		float barWidth = 40.f;
+		Rectangle bar = { transform.position.x - barWidth * 0.5f, transform.position.y + size * 0.5f + 6.f, barWidth, 5.f };
+		out.Rect(RenderLayer::WORLD_UI, bar, DARKGRAY);
+		out.Rect(RenderLayer::WORLD_UI, { bar.x, bar.y, barWidth * hp / MAX_HP, bar.height }, RED);
+	}
+
+	float GetRadius() const override {
+		return (SPRITE_SIZE * SCALE) * 0.5f;
+	}
+
+	CollisionFilter GetFilter() const override {
+		return FILTER_ENEMY;
+	}
+
+	Vector2 GetVelocity() const {
+		return velocity;
+	}
+
+	uint32_t GetScript() const {
+		return script;
+	}
+
+	static constexpr int MAX_HP = 60;
+	static constexpr int RAM_DAMAGE = 30; // to the player when they collide, the gunship is destroyed
+	static constexpr int SCORE = 100;
+	static constexpr float SPEED = 220.f;
+	static constexpr float SHOT_SPEED = 520.f;
+
+private:
+	static constexpr float SCALE = 0.15f;
+	static constexpr float SPRITE_SIZE = 512.f;
+
+	Vector2 velocity{};
+	float facing = 0.f;
+	uint32_t script;
+};
+
+// Picks a spot at a standoff distance from the player, fires a few fanned
+// volleys from there, then circles for a while before repositioning.
+static inline EnemyScript GunshipScript(ScriptScheduler& s, uint32_t self, float speed) {
+	for (;;) {
+		float ang = s.Random(self, 0.f, 2.f * PI);
+		float range = s.Random(self, 380.f, 520.f);
+		Vector2 spot = Vector2Add(s.PlayerPos(), { cosf(ang) * range, sinf(ang) * range });
+		co_await MoveTo(spot, speed);
+
+		int volleys = static_cast<int>(s.Random(self, 2.f, 4.99f));
+		for (int v = 0; v < volleys; ++v) {
+			co_await Wait(s.Random(self, 0.25f, 0.45f));
+			co_await Volley(5, 0.6f, 0.1f);
+		}
+		co_await Orbit(range, speed * 0.7f, s.Random(self, 0.f, 1.f) < 0.5f ? 1.f : -1.f, s.Random(self, 1.5f, 2.5f));
+	}
+}
+
+// --- BROADPHASE ---
+struct Aabb {
+	float minX, minY, maxX, maxY;
+};
+
+// Sweep-and-prune on the x axis. `order` keeps body indices sorted by the left
+// edge of their box and persists between frames; bodies move little per frame,
+// so the insertion sort that restores it runs in close to linear time.
+class SweepAndPrune {
+public:
+	struct Stats {
+		long long candidates = 0; // pairs overlapping on x
+		long long overlaps = 0;   // pairs overlapping on both axes
+		long long swaps = 0;      // insertion sort moves
+	};
+
+	void Reserve(size_t n) {
+		order.reserve(n);
+		swept.reserve(n);
+	}
+
+	void Clear() {
+		order.clear();
+		swept.clear();
+	}
+
+	// Adds a body, it gets sorted in on the next Sweep
+	void Insert(uint32_t index) {
+		order.push_back(index);
+	}
+
+	// Renumbers bodies after the owner reordered its array.
+	// remap[old] is the new index, or UINT32_MAX when the body was removed.
+	void Remap(const std::vector<uint32_t>& remap) {
+		size_t out = 0;
+		size_t sorted = 0;
+		for (size_t i = 0; i < order.size(); ++i) {
+			if (remap[order[i]] == UINT32_MAX) continue;
+			if (i < swept.size()) swept[sorted++] = swept[i]; // the swept bodies stay in front
+			order[out++] = remap[order[i]];
+		}
+		order.resize(out);
+		swept.resize(sorted);
+	}
+
+	// Calls onPair(i, j), i < j, for every pair of overlapping boxes
+	template <typename OnPair>
+	void Sweep(const std::vector<Aabb>& boxes, OnPair&& onPair) {
+		stats = {};
+
+		for (size_t i = 1; i < order.size(); ++i) {
+			uint32_t idx = order[i];
+			float key = boxes[idx].minX;
+			size_t j = i;
+			while (j > 0 && boxes[order[j - 1]].minX > key) {
+				order[j] = order[j - 1];
+				--j;
+				++stats.swaps;
+			}
+			order[j] = idx;
+		}
+
+		swept.resize(order.size());
+		maxWidth = 0.f;
+		for (size_t i = 0; i < order.size(); ++i) {
+			const Aabb& bi = boxes[order[i]];
+			swept[i] = bi;
+			maxWidth = std::max(maxWidth, bi.maxX - bi.minX);
+			for (size_t j = i + 1; j < order.size(); ++j) {
+				const Aabb& bj = boxes[order[j]];
+				if (bj.minX > bi.maxX) break;
+				++stats.candidates;
+				if (bj.minY > bi.maxY || bj.maxY < bi.minY) continue;
+				++stats.overlaps;
+				onPair(std::min(order[i], order[j]), std::max(order[i], order[j]));
+			}
+		}
+	}
+
+	// Body indices by left edge as of the last Sweep
+	const std::vector<uint32_t>& GetOrder() const {
+		return order;
+	}
+
+	// Fills `out` with the bodies whose box at the last Sweep overlapped `box`,
+	// then every body inserted since, whose box is not known yet. Only the slice
+	// of `order` whose left edges can reach the box is scanned. Returns false,
+	// leaving `out` empty, when that slice holds most bodies: walking all of them
+	// front to back is then cheaper than gathering and visiting them in sweep order.
+	bool CollectOverlapping(const Aabb& box, std::vector<uint32_t>& out) const {
+		out.clear();
+		auto first = std::lower_bound(swept.begin(), swept.end(), box.minX - maxWidth,
+			[](const Aabb& b, float x) { return b.minX < x; });
+		auto last = std::upper_bound(first, swept.end(), box.maxX,
+			[](float x, const Aabb& b) { return x < b.minX; });
+		if (2 * static_cast<size_t>(last - first) > order.size()) return false;
+		for (auto it = first; it != last; ++it) {
+			if (it->maxX >= box.minX && it->maxY >= box.minY && it->minY <= box.maxY) out.push_back(order[it - swept.begin()]);
+		}
+		out.insert(out.end(), order.begin() + swept.size(), order.end());
+		return true;
+	}
+
+	const Stats& GetStats() const {
+		return stats;
+	}
+
+private:
+	std::vector<uint32_t> order;
+	std::vector<Aabb> swept; // box of order[i] at the last Sweep, for the bodies swept so far
+	float maxWidth = 0.f;    // widest of them
+	Stats stats;
+};
+
+// Circle colliders bucketed by collision layer, rebuilt every tick. A query
+// walks layer pairs: a pair of layers whose masks exclude each other is skipped
+// whole, before a single box or distance test. Within the other pairs the
+// larger bucket is sorted by left edge, so each collider of the smaller one
+// only scans the slice that can overlap it on x; tiny pairs are tested
+// directly. Per-collider masks are checked on each such candidate before the
+// distance test.
+class LayeredBroadphase {
+public:
+	struct Stats {
+		long long candidates = 0;   // pairs overlapping on x that passed the masks
+		long long maskRejected = 0; // pairs the masks ruled out, whole layer pairs included
+		long long contacts = 0;     // pairs whose circles overlap
+	};
+
+	void Reserve(uint8_t layer, size_t n) {
+		buckets[LayerIndex(layer)].reserve(n);
+	}
+
+	void Clear() {
+		for (int l = 0; l < COLLISION_LAYER_COUNT; ++l) {
+			buckets[l].clear();
+			maskUnion[l] = 0;
+			maxWidth[l] = 0.f;
+			sorted[l] = false;
+		}
+	}
+
+	// `layers` collide with themselves elsewhere (asteroids go through SweepAndPrune)
+	void SkipSelfPairs(uint8_t layers) {
+		skipSelf = layers;
+	}
+
+	void Add(CollisionFilter filter, Vector2 center, float radius, uint32_t id) {
+		int l = LayerIndex(filter.layer);
+		buckets[l].push_back({ center.x - radius, center.x + radius, center, radius, filter.mask, id });
+		maskUnion[l] |= filter.mask;
+		maxWidth[l] = std::max(maxWidth[l], 2.f * radius);
+	}
+
+	// The caller added `layer`'s colliders in left edge order already, so the
+	// query uses the bucket as it is instead of sorting it
+	void MarkSorted(uint8_t layer) {
+		sorted[LayerIndex(layer)] = true;
+	}
+
+	// Calls onContact(layerA, idA, layerB, idB) with layerA <= layerB for every
+	// overlapping pair the masks allow
+	template <typename OnContact>
+	void Query(OnContact&& onContact) {
+		stats = {};
+		for (int la = 0; la < COLLISION_LAYER_COUNT; ++la) {
+			for (int lb = la; lb < COLLISION_LAYER_COUNT; ++lb) {
+				uint8_t bitA = static_cast<uint8_t>(1 << la);
+				uint8_t bitB = static_cast<uint8_t>(1 << lb);
+				long long na = static_cast<long long>(buckets[la].size());
+				long long nb = static_cast<long long>(buckets[lb].size());
+				if (la == lb && (skipSelf & bitA) != 0) continue;
+				long long pairs = (la == lb) ? na * (na - 1) / 2 : na * nb;
+				if (pairs == 0) continue;
+				if ((maskUnion[la] & bitB) == 0 || (maskUnion[lb] & bitA) == 0) {
+					stats.maskRejected += pairs;
+					continue;
+				}
+				if (pairs <= C_DIRECT_PAIRS) TestAll(la, lb, onContact);
+				else if (la == lb) SweepSelf(la, onContact);
+				else SweepPair(la, lb, onContact);
+			}
+		}
+	}
+
+	const Stats& GetStats() const {
+		return stats;
+	}
+
+private:
+	struct Collider {
+		float minX, maxX;
+		Vector2 center;
+		float radius;
+		uint8_t mask;
+		uint32_t id;
+	};
+
+	static constexpr long long C_DIRECT_PAIRS = 64; // below this sorting costs more than it saves
+
+	static int LayerIndex(uint8_t layer) {
+		int l = 0;
+		while ((layer >> l) != 1) ++l;
+		return l;
+	}
+
+	// Sorted by left edge on first use in a query, ties by id so the order is reproducible
+	void Sort(int l) {
+		if (sorted[l]) return;
+		std::sort(buckets[l].begin(), buckets[l].end(), [](const Collider& a, const Collider& b) {
+			return a.minX != b.minX ? a.minX < b.minX : a.id < b.id;
+		});
+		sorted[l] = true;
+	}
+
+	template <typename OnContact>
+	void Test(int la, const Collider& a, int lb, const Collider& b, OnContact& onContact) {
+		uint8_t bitA = static_cast<uint8_t>(1 << la);
+		uint8_t bitB = static_cast<uint8_t>(1 << lb);
+		if ((a.mask & bitB) == 0 || (b.mask & bitA) == 0) {
+			++stats.maskRejected;
+			return;
+		}
+		++stats.candidates;
+		float reach = a.radius + b.radius;
+		if (Vector2DistanceSqr(a.center, b.center) >= reach * reach) return;
+		++stats.contacts;
+		onContact(bitA, a.id, bitB, b.id);
+	}
+
+	// Every pair with a box overlap on x, without sorting
+	template <typename OnContact>
+	void TestAll(int la, int lb, OnContact& onContact) {
+		const std::vector<Collider>& a = buckets[la];
+		const std::vector<Collider>& b = buckets[lb];
+		for (size_t i = 0; i < a.size(); ++i) {
+			for (size_t j = (la == lb) ? i + 1 : 0; j < b.size(); ++j) {
+				if (b[j].minX > a[i].maxX || b[j].maxX < a[i].minX) continue;
+				bool ordered = la != lb || a[i].id < b[j].id;
+				Test(la, ordered ? a[i] : b[j], lb, ordered ? b[j] : a[i], onContact);
+			}
+		}
+	}
+
+	// Each collider of one bucket scans the part of the other, sorted one whose
+	// left edges lie within [minX - widest box, maxX]. A bucket that is sorted
+	// already is the one scanned; otherwise the larger one is sorted.
+	template <typename OnContact>
+	void SweepPair(int la, int lb, OnContact& onContact) {
+		bool aOuter = (sorted[la] != sorted[lb]) ? sorted[lb] : buckets[la].size() <= buckets[lb].size();
+		int lo = aOuter ? la : lb;
+		int li = aOuter ? lb : la;
+		Sort(li);
+		const std::vector<Collider>& inner = buckets[li];
+		for (const Collider& o : buckets[lo]) {
+			auto first = std::lower_bound(inner.begin(), inner.end(), o.minX - maxWidth[li],
+				[](const Collider& c, float x) { return c.minX < x; });
+			for (auto it = first; it != inner.end() && it->minX <= o.maxX; ++it) {
+				if (it->maxX < o.minX) continue;
+				if (aOuter) Test(la, o, lb, *it, onContact);
+				else Test(la, *it, lb, o, onContact);
+			}
+		}
+	}
+
+	template <typename OnContact>
+	void SweepSelf(int l, OnContact& onContact) {
+		Sort(l);
+		const std::vector<Collider>& bucket = buckets[l];
+		for (size_t i = 0; i < bucket.size(); ++i) {
+			for (size_t j = i + 1; j < bucket.size() && bucket[j].minX <= bucket[i].maxX; ++j) {
+				const Collider& a = bucket[i].id < bucket[j].id ? bucket[i] : bucket[j];
+				const Collider& b = bucket[i].id < bucket[j].id ? bucket[j] : bucket[i];
+				Test(l, a, l, b, onContact);
+			}
+		}
+	}
+
+	std::array<std::vector<Collider>, COLLISION_LAYER_COUNT> buckets;
+	std::array<uint8_t, COLLISION_LAYER_COUNT> maskUnion{};
+	std::array<float, COLLISION_LAYER_COUNT> maxWidth{};
+	std::array<bool, COLLISION_LAYER_COUNT> sorted{};
+	uint8_t skipSelf = 0;
+	Stats stats;
+};
+
+// --- NARROWPHASE ---
+// Exact tests for pairs whose bounding circles already overlap: asteroids are
+// their ASTEROID_HULLS outline, shots and the ship stay circles. A queued pair
+// is stored in the frame of its (first) hull, scaled to that hull's radius, so
+// the outline's face normals and edges are precomputed once per kind and never
+// rotated. Pairs run grouped by kind - by kind pair for two hulls - so a batch
+// shares one outline, its axes are broadcast and FloatLanes::COUNT pairs go
+// through every face together.
+//   Circle vs hull: touching when the center is inside every face or within
+//   the radius of an edge.
+//   Hull vs hull: separating axis test over the face normals of both; for a
+//   touching pair the axis of least overlap gives the push-out normal and depth.
+class Narrowphase {
+public:
+	struct Stats {
+		long long circlePairs = 0;
+		long long hullPairs = 0;
+		long long rejected = 0; // bounding circles overlapped, the shapes do not
+	};
+
+	// Push-out from the first shape to the second in world space, zero for circle pairs
+	struct Contact {
+		Vector2 normal;
+		float depth;
+	};
+
+	Narrowphase() {
+		for (size_t k = 0; k < ASTEROID_KIND_COUNT; ++k) {
+			const HullOutline& outline = ASTEROID_HULLS[k];
+			Hull& h = hulls[k];
+			h.count = outline.count;
+			for (int i = 0; i < outline.count; ++i) {
+				Vector2 v = outline.vertices[i];
+				Vector2 e = Vector2Subtract(outline.vertices[(i + 1) % outline.count], v);
+				Vector2 n = Vector2Normalize({ e.y, -e.x });
+				if (Vector2DotProduct(n, v) < 0.f) n = Vector2Negate(n); // the center is inside every outline
+				h.vx[i] = v.x;
+				h.vy[i] = v.y;
+				h.ex[i] = e.x;
+				h.ey[i] = e.y;
+				h.invLenSq[i] = 1.f / Vector2DotProduct(e, e);
+				h.nx[i] = n.x;
+				h.ny[i] = n.y;
+				h.d[i] = Vector2DotProduct(n, v);
+			}
+		}
+	}
+
+	void Reserve(size_t pairs) {
+		circles.reserve(pairs);
+		hullPairs.reserve(pairs);
+		order.reserve(pairs);
+	}
+
+	void Clear() {
+		circles.clear();
+		hullPairs.clear();
+	}
+
+	// Scalar path for every pair, to compare against the batched one
+	void SetBatched(bool on) {
+		batched = on;
+	}
+
+	// A circle against the hull of `kind` placed at `pose`
+	void AddCircle(AsteroidKind kind, const ShapePose& pose, Vector2 center, float radius, uint32_t tag) {
+		Vector2 d = Vector2Subtract(center, pose.position);
+		float inv = 1.f / pose.radius;
+		circles.push_back({
+			(d.x * pose.cos + d.y * pose.sin) * inv,
+			(d.y * pose.cos - d.x * pose.sin) * inv,
+			radius * inv, tag, static_cast<uint8_t>(kind) });
+	}
+
+	// Hull b against hull a, the contact normal points from a to b
+	void AddHulls(AsteroidKind ka, const ShapePose& a, AsteroidKind kb, const ShapePose& b, uint32_t tag) {
+		Vector2 d = Vector2Subtract(b.position, a.position);
+		float inv = 1.f / a.radius;
+		hullPairs.push_back({
+			(d.x * a.cos + d.y * a.sin) * inv,
+			(d.y * a.cos - d.x * a.sin) * inv,
+			b.cos * a.cos + b.sin * a.sin, // rotation of b relative to a
+			b.sin * a.cos - b.cos * a.sin,
+			b.radius * inv,
+			a.cos, a.sin, a.radius, tag,
+			static_cast<uint8_t>(static_cast<size_t>(ka) * ASTEROID_KIND_COUNT + static_cast<size_t>(kb)) });
+	}
+
+	// Calls onTouch(tag, Contact) for every queued pair whose shapes touch
+	template <typename OnTouch>
+	void Run(OnTouch&& onTouch) {
+		stats = {};
+		stats.circlePairs = static_cast<long long>(circles.size());
+		stats.hullPairs = static_cast<long long>(hullPairs.size());
+		if (circles.empty() && hullPairs.empty()) return; // most ticks of a sparse world
+		long long touching = 0;
+
+		SortByBucket(circles, ASTEROID_KIND_COUNT);
+		for (size_t k = 0; k < ASTEROID_KIND_COUNT; ++k) {
+			touching += RunCircles(hulls[k], order.data() + bucketStart[k], bucketStart[k + 1] - bucketStart[k], onTouch);
+		}
+		SortByBucket(hullPairs, HULL_BUCKETS);
+		for (size_t b = 0; b < HULL_BUCKETS; ++b) {
+			touching += RunHulls(hulls[b / ASTEROID_KIND_COUNT], hulls[b % ASTEROID_KIND_COUNT],
+				order.data() + bucketStart[b], bucketStart[b + 1] - bucketStart[b], onTouch);
+		}
+		stats.rejected = stats.circlePairs + stats.hullPairs - touching;
+	}
+
+	const Stats& GetStats() const {
+		return stats;
+	}
+
+private:
+	static constexpr size_t HULL_BUCKETS = ASTEROID_KIND_COUNT * ASTEROID_KIND_COUNT;
+	static constexpr int LANES = FloatLanes::COUNT;
+
+	// One outline, structure of arrays so a face's numbers broadcast straight into lanes
+	struct Hull {
+		int count = 0;
+		float vx[C_HULL_MAX_VERTICES]{};       // vertex i
+		float vy[C_HULL_MAX_VERTICES]{};
+		float ex[C_HULL_MAX_VERTICES]{};       // edge from vertex i to i + 1
+		float ey[C_HULL_MAX_VERTICES]{};
+		float invLenSq[C_HULL_MAX_VERTICES]{};
+		float nx[C_HULL_MAX_VERTICES]{};       // outward normal of edge i
+		float ny[C_HULL_MAX_VERTICES]{};
+		float d[C_HULL_MAX_VERTICES]{};        // distance of edge i from the center
+	};
+
+	// Circle in the hull's frame and units
+	struct CirclePair {
+		float x, y, radius;
+		uint32_t tag;
+		uint8_t bucket; // hull kind
+	};
+
+	// Hull b in a's frame and units, plus a's pose to turn the contact back into world space
+	struct HullPair {
+		float x, y, cos, sin, scale;
+		float aCos, aSin, aRadius;
+		uint32_t tag;
+		uint8_t bucket; // kind of a * ASTEROID_KIND_COUNT + kind of b
+	};
+
+	// Counting sort of pair indices into `order`, bucket b spans [bucketStart[b], bucketStart[b + 1])
+	template <typename Pair>
+	void SortByBucket(const std::vector<Pair>& pairs, size_t buckets) {
+		bucketStart.fill(0);
+		for (const Pair& p : pairs) ++bucketStart[p.bucket + 1];
+		for (size_t b = 0; b < buckets; ++b) bucketStart[b + 1] += bucketStart[b];
+		std::array<uint32_t, HULL_BUCKETS + 1> next = bucketStart;
+		order.resize(pairs.size());
+		for (uint32_t i = 0; i < pairs.size(); ++i) order[next[pairs[i].bucket]++] = i;
+	}
+
+	template <typename OnTouch>
+	long long RunCircles(const Hull& h, const uint32_t* idx, size_t n, OnTouch& onTouch) {
+		long long touching = 0;
+		if (!batched) {
+			for (size_t i = 0; i < n; ++i) {
+				if (CircleTouches(h, circles[idx[i]])) {
+					onTouch(circles[idx[i]].tag, Contact{});
+					++touching;
+				}
+			}
+			return touching;
+		}
+
+		float px[LANES], py[LANES], pr[LANES];
+		for (size_t base = 0; base < n; base += LANES) {
+			// A short last batch repeats its final pair in the spare lanes
+			size_t lanes = std::min<size_t>(LANES, n - base);
+			for (size_t l = 0; l < LANES; ++l) {
+				const CirclePair& c = circles[idx[base + std::min(l, lanes - 1)]];
+				px[l] = c.x;
+				py[l] = c.y;
+				pr[l] = c.radius;
+			}
+			FloatLanes x = FloatLanes::Load(px);
+			FloatLanes y = FloatLanes::Load(py);
+			FloatLanes r = FloatLanes::Load(pr);
+			FloatLanes zero = FloatLanes::Splat(0.f);
+			FloatLanes one = FloatLanes::Splat(1.f);
+			FloatLanes outside = FloatLanes::Splat(-FLT_MAX);
+			FloatLanes nearest = FloatLanes::Splat(FLT_MAX);
+			for (int i = 0; i < h.count; ++i) {
+				FloatLanes s = FloatLanes::Splat(h.nx[i]) * x + FloatLanes::Splat(h.ny[i]) * y - FloatLanes::Splat(h.d[i]);
+				outside = Max(outside, s);
+				FloatLanes ex = FloatLanes::Splat(h.ex[i]);
+				FloatLanes ey = FloatLanes::Splat(h.ey[i]);
+				FloatLanes dx = x - FloatLanes::Splat(h.vx[i]);
+				FloatLanes dy = y - FloatLanes::Splat(h.vy[i]);
+				FloatLanes t = Min(Max((dx * ex + dy * ey) * FloatLanes::Splat(h.invLenSq[i]), zero), one);
+				FloatLanes qx = dx - t * ex;
+				FloatLanes qy = dy - t * ey;
+				nearest = Min(nearest, qx * qx + qy * qy);
+			}
+			uint32_t touch = Bits((outside <= zero) | (nearest <= r * r));
+			for (size_t l = 0; l < lanes; ++l) {
+				if ((touch & (1u << l)) == 0) continue;
+				onTouch(circles[idx[base + l]].tag, Contact{});
+				++touching;
+			}
+		}
+		return touching;
+	}
+
+	template <typename OnTouch>
+	long long RunHulls(const Hull& a, const Hull& b, const uint32_t* idx, size_t n, OnTouch& onTouch) {
+		long long touching = 0;
+		if (!batched) {
+			for (size_t i = 0; i < n; ++i) {
+				const HullPair& p = hullPairs[idx[i]];
+				Vector2 normal{};
+				float gap = HullGap(a, b, p, normal);
+				if (gap > 0.f) continue;
+				onTouch(p.tag, ToWorld(p, normal, gap));
+				++touching;
+			}
+			return touching;
+		}
+
+		float px[LANES], py[LANES], pc[LANES], ps[LANES], pk[LANES];
+		float outGap[LANES], outNx[LANES], outNy[LANES];
+		for (size_t base = 0; base < n; base += LANES) {
+			size_t lanes = std::min<size_t>(LANES, n - base);
+			for (size_t l = 0; l < LANES; ++l) {
+				const HullPair& p = hullPairs[idx[base + std::min(l, lanes - 1)]];
+				px[l] = p.x;
+				py[l] = p.y;
+				pc[l] = p.cos;
+				ps[l] = p.sin;
+				pk[l] = p.scale;
+			}
+			FloatLanes x = FloatLanes::Load(px);
+			FloatLanes y = FloatLanes::Load(py);
+			FloatLanes c = FloatLanes::Load(pc);
+			FloatLanes s = FloatLanes::Load(ps);
+			FloatLanes k = FloatLanes::Load(pk);
+
+			// b's corners in a's frame
+			FloatLanes bx[C_HULL_MAX_VERTICES];
+			FloatLanes by[C_HULL_MAX_VERTICES];
+			for (int j = 0; j < b.count; ++j) {
+				FloatLanes ux = FloatLanes::Splat(b.vx[j]);
+				FloatLanes uy = FloatLanes::Splat(b.vy[j]);
+				bx[j] = x + k * (c * ux - s * uy);
+				by[j] = y + k * (s * ux + c * uy);
+			}
+
+			// Largest gap over all axes: positive means separated, otherwise minus the overlap
+			FloatLanes gap = FloatLanes::Splat(-FLT_MAX);
+			FloatLanes gapX = FloatLanes::Splat(0.f);
+			FloatLanes gapY = FloatLanes::Splat(0.f);
+			for (int i = 0; i < a.count; ++i) {
+				FloatLanes nx = FloatLanes::Splat(a.nx[i]);
+				FloatLanes ny = FloatLanes::Splat(a.ny[i]);
+				FloatLanes lowest = FloatLanes::Splat(FLT_MAX);
+				for (int j = 0; j < b.count; ++j) lowest = Min(lowest, nx * bx[j] + ny * by[j]);
+				FloatLanes g = lowest - FloatLanes::Splat(a.d[i]);
+				MaskLanes wider = g > gap;
+				gap = Select(wider, g, gap);
+				gapX = Select(wider, nx, gapX);
+				gapY = Select(wider, ny, gapY);
+			}
+			for (int j = 0; j < b.count; ++j) {
+				FloatLanes ux = FloatLanes::Splat(b.nx[j]);
+				FloatLanes uy = FloatLanes::Splat(b.ny[j]);
+				FloatLanes nx = c * ux - s * uy;
+				FloatLanes ny = s * ux + c * uy;
+				FloatLanes face = nx * x + ny * y + k * FloatLanes::Splat(b.d[j]);
+				FloatLanes lowest = FloatLanes::Splat(FLT_MAX);
+				for (int i = 0; i < a.count; ++i) lowest = Min(lowest, nx * FloatLanes::Splat(a.vx[i]) + ny * FloatLanes::Splat(a.vy[i]));
+				FloatLanes g = lowest - face;
+				MaskLanes wider = g > gap;
+				gap = Select(wider, g, gap);
+				gapX = Select(wider, FloatLanes::Splat(0.f) - nx, gapX);
+				gapY = Select(wider, FloatLanes::Splat(0.f) - ny, gapY);
+			}
+
+			uint32_t touch = Bits(gap <= FloatLanes::Splat(0.f));
+			if (touch == 0) continue;
+			Store(outGap, gap);
+			Store(outNx, gapX);
+			Store(outNy, gapY);
+			for (size_t l = 0; l < lanes; ++l) {
+				if ((touch & (1u << l)) == 0) continue;
+				const HullPair& p = hullPairs[idx[base + l]];
+				onTouch(p.tag, ToWorld(p, { outNx[l], outNy[l] }, outGap[l]));
+				++touching;
+			}
+		}
+		return touching;
+	}
+
+	// Scalar twin of the batched circle test
+	static bool CircleTouches(const Hull& h, const CirclePair& c) {
+		float outside = -FLT_MAX;
+		float nearest = FLT_MAX;
+		for (int i = 0; i < h.count; ++i) {
+			outside = std::max(outside, h.nx[i] * c.x + h.ny[i] * c.y - h.d[i]);
+			float dx = c.x - h.vx[i];
+			float dy = c.y - h.vy[i];
+			float t = Clamp((dx * h.ex[i] + dy * h.ey[i]) * h.invLenSq[i], 0.f, 1.f);
+			float qx = dx - t * h.ex[i];
+			float qy = dy - t * h.ey[i];
+			nearest = std::min(nearest, qx * qx + qy * qy);
+		}
+		return outside <= 0.f || nearest <= c.radius * c.radius;
+	}
+
+	// Scalar twin of the batched hull test: the largest gap and its axis, in a's frame
+	static float HullGap(const Hull& a, const Hull& b, const HullPair& p, Vector2& normal) {
+		float bx[C_HULL_MAX_VERTICES];
+		float by[C_HULL_MAX_VERTICES];
+		for (int j = 0; j < b.count; ++j) {
+			bx[j] = p.x + p.scale * (p.cos * b.vx[j] - p.sin * b.vy[j]);
+			by[j] = p.y + p.scale * (p.sin * b.vx[j] + p.cos * b.vy[j]);
+		}
+		float gap = -FLT_MAX;
+		for (int i = 0; i < a.count; ++i) {
+			float lowest = FLT_MAX;
+			for (int j = 0; j < b.count; ++j) lowest = std::min(lowest, a.nx[i] * bx[j] + a.ny[i] * by[j]);
+			float g = lowest - a.d[i];
+			if (g > gap) {
+				gap = g;
+				normal = { a.nx[i], a.ny[i] };
+			}
+		}
+		for (int j = 0; j < b.count; ++j) {
+			float nx = p.cos * b.nx[j] - p.sin * b.ny[j];
+			float ny = p.sin * b.nx[j] + p.cos * b.ny[j];
+			float face = nx * p.x + ny * p.y + p.scale * b.d[j];
+			float lowest = FLT_MAX;
+			for (int i = 0; i < a.count; ++i) lowest = std::min(lowest, nx * a.vx[i] + ny * a.vy[i]);
+			float g = lowest - face;
+			if (g > gap) {
+				gap = g;
+				normal = { -nx, -ny };
+			}
+		}
+		return gap;
+	}
+
+	// Normal from a's frame to world space, overlap from a's units to pixels
+	static Contact ToWorld(const HullPair& p, Vector2 normal, float gap) {
+		return {
+			{ p.aCos * normal.x - p.aSin * normal.y, p.aSin * normal.x + p.aCos * normal.y },
+			-gap * p.aRadius
+		};
+	}
+
+	std::array<Hull, ASTEROID_KIND_COUNT> hulls;
+	std::vector<CirclePair> circles;
+	std::vector<HullPair> hullPairs;
+	std::vector<uint32_t> order;
+	std::array<uint32_t, HULL_BUCKETS + 1> bucketStart{};
+	bool batched = true;
+	Stats stats;
+};
+
+// --- WORLD CHUNKS ---
+// The world is a grid of square chunks around the player's chunk:
+//  ACTIVE   - within C_ACTIVE_RADIUS, asteroids live in the simulation's active set
+//             with full update, collisions and drawing
+//  REDUCED  - the ring out to C_REDUCED_RADIUS, asteroids move every
+//             C_REDUCED_INTERVAL ticks (staggered per chunk) without collisions
+//  SLEEPING - everything farther, asteroids stay frozen until the chunk comes close
+// Asteroids outside the active set are parked here in a fixed pool with one
+// linked list per chunk, so moving them between chunks never allocates.
+enum class ChunkActivity : uint8_t { SLEEPING, REDUCED, ACTIVE };
+
+class ChunkGrid {
+public:
+	static constexpr int C_ACTIVE_RADIUS = 2;
+	static constexpr int C_REDUCED_RADIUS = 4;
+	static constexpr uint64_t C_REDUCED_INTERVAL = 4;
+
+	ChunkGrid(int columnCount, int rowCount, float size, size_t poolCapacity)
+		: columns(columnCount), rows(rowCount), chunkSize(size), capacity(poolCapacity)
+	{
+		size_t n = static_cast<size_t>(columns) * rows;
+		activity.assign(n, ChunkActivity::SLEEPING);
+		lastTick.assign(n, 0.0);
+		head.assign(n, NONE);
+		counts.assign(n, 0);
+		pool.reserve(capacity);
+		next.reserve(capacity);
+		movers.reserve(capacity); // at most every parked asteroid changes chunk in one tick
+	}
+
+	// Forgets every parked asteroid and puts the whole world to sleep
+	void Clear() {
+		std::fill(activity.begin(), activity.end(), ChunkActivity::SLEEPING);
+		std::fill(head.begin(), head.end(), NONE);
+		std::fill(counts.begin(), counts.end(), 0u);
+		pool.clear();
+		next.clear();
+		freeHead = NONE;
+		parked = 0;
+		centerX = centerY = -1;
+	}
+
+	int ChunkOf(Vector2 p) const {
+		int cx = Clamp(static_cast<int>(floorf(p.x / chunkSize)), 0, columns - 1);
+		int cy = Clamp(static_cast<int>(floorf(p.y / chunkSize)), 0, rows - 1);
+		return cy * columns + cx;
+	}
+
+	ChunkActivity Activity(int chunk) const {
+		return activity[chunk];
+	}
+
+	uint32_t Count(int chunk) const {
+		return counts[chunk];
+	}
+
+	int Columns() const {
+		return columns;
+	}
+
+	int Rows() const {
+		return rows;
+	}
+
+	float ChunkSize() const {
+		return chunkSize;
+	}
+
+	size_t ParkedCount() const {
+		return parked;
+	}
+
+	// Focused, and the grid fits in the active ring around any of its chunks: every
+	// chunk is ACTIVE wherever the player goes, so nothing is parked, reduced or
+	// leaves the active set until the next Clear (the batch environment's arena)
+	bool AllActive() const {
+		return centerX >= 0 && columns <= C_ACTIVE_RADIUS + 1 && rows <= C_ACTIVE_RADIUS + 1;
+	}
+
+	// World-space box of the active chunks
+	Rectangle ActiveBounds() const {
+		int x0 = std::max(centerX - C_ACTIVE_RADIUS, 0);
+		int y0 = std::max(centerY - C_ACTIVE_RADIUS, 0);
+		int x1 = std::min(centerX + C_ACTIVE_RADIUS, columns - 1);
+		int y1 = std::min(centerY + C_ACTIVE_RADIUS, rows - 1);
+		return { x0 * chunkSize, y0 * chunkSize, (x1 - x0 + 1) * chunkSize, (y1 - y0 + 1) * chunkSize };
+	}
+
+	// Re-centers the activity rings on `chunk`. Only cells around the old and the
+	// new center are touched. onWake(chunk, previous) runs for every chunk that
+	// just became ACTIVE, previous is what it was before.
+	template <typename OnWake>
+	void Focus(int chunk, double now, OnWake&& onWake) {
+		int cx = chunk % columns;
+		int cy = chunk / columns;
+		if (cx == centerX && cy == centerY) return;
+
+		for (int y = std::max(cy - C_REDUCED_RADIUS, 0); y <= std::min(cy + C_REDUCED_RADIUS, rows - 1); ++y) {
+			for (int x = std::max(cx - C_REDUCED_RADIUS, 0); x <= std::min(cx + C_REDUCED_RADIUS, columns - 1); ++x) {
+				int c = y * columns + x;
+				int ring = std::max(std::abs(x - cx), std::abs(y - cy));
+				ChunkActivity after = (ring <= C_ACTIVE_RADIUS) ? ChunkActivity::ACTIVE : ChunkActivity::REDUCED;
+				ChunkActivity before = activity[c];
+				if (after == before) continue;
+				activity[c] = after;
+				if (after == ChunkActivity::ACTIVE) {
+					onWake(c, before);
+				}
+				else {
+					lastTick[c] = now;
+				}
+			}
+		}
+
+		if (centerX >= 0) {
+			for (int y = std::max(centerY - C_REDUCED_RADIUS, 0); y <= std::min(centerY + C_REDUCED_RADIUS, rows - 1); ++y) {
+				for (int x = std::max(centerX - C_REDUCED_RADIUS, 0); x <= std::min(centerX + C_REDUCED_RADIUS, columns - 1); ++x) {
+					if (std::abs(x - cx) > C_REDUCED_RADIUS || std::abs(y - cy) > C_REDUCED_RADIUS) {
+						activity[y * columns + x] = ChunkActivity::SLEEPING;
+					}
+				}
+			}
+		}
+		centerX = cx;
+		centerY = cy;
+	}
+
+	// Seconds since a REDUCED chunk last moved its asteroids
+	double SinceTick(int chunk, double now) const {
+		return now - lastTick[chunk];
+	}
+
+	// Stores an asteroid in its chunk. Returns false when the pool is full and the asteroid was dropped.
+	bool Park(const Asteroid& a) {
+		uint32_t slot;
+		if (freeHead != NONE) {
+			slot = freeHead;
+			freeHead = next[slot];
+			pool[slot] = a;
+		}
+		else if (pool.size() < capacity) {
+			slot = static_cast<uint32_t>(pool.size());
+			pool.push_back(a);
+			next.push_back(NONE);
+		}
+		else {
+			return false;
+		}
+		Link(slot, ChunkOf(a.GetPosition()));
+		++parked;
+		return true;
+	}
+
+	// Hands every asteroid of `chunk` to f(Asteroid&) and empties the chunk
+	template <typename F>
+	void Drain(int chunk, F&& f) {
+		uint32_t slot = head[chunk];
+		while (slot != NONE) {
+			uint32_t following = next[slot];
+			f(pool[slot]);
+			Release(slot);
+			slot = following;
+		}
+		head[chunk] = NONE;
+		counts[chunk] = 0;
+	}
+
+	// Moves the asteroids of the REDUCED chunks whose turn it is this tick.
+	// update(Asteroid&, dt) advances one asteroid; asteroids that end up in an
+	// ACTIVE chunk leave the grid through onEnterActive(const Asteroid&).
+	// Returns how many asteroids were moved.
+	template <typename Update, typename OnEnterActive>
+	size_t TickReduced(uint64_t tick, double now, Update&& update, OnEnterActive&& onEnterActive) {
+		size_t moved = 0;
+		movers.clear();
+		for (int y = std::max(centerY - C_REDUCED_RADIUS, 0); y <= std::min(centerY + C_REDUCED_RADIUS, rows - 1); ++y) {
+			for (int x = std::max(centerX - C_REDUCED_RADIUS, 0); x <= std::min(centerX + C_REDUCED_RADIUS, columns - 1); ++x) {
+				int c = y * columns + x;
+				if (activity[c] != ChunkActivity::REDUCED || (tick + c) % C_REDUCED_INTERVAL != 0) continue;
+
+				float dt = static_cast<float>(now - lastTick[c]);
+				lastTick[c] = now;
+				uint32_t* link = &head[c];
+				while (*link != NONE) {
+					uint32_t slot = *link;
+					update(pool[slot], dt);
+					++moved;
+					int target = ChunkOf(pool[slot].GetPosition());
+					if (target == c) {
+						link = &next[slot];
+						continue;
+					}
+					// Relinked after the sweep so no asteroid moves twice in one tick
+					*link = next[slot];
+					--counts[c];
+					movers.push_back({ slot, target });
+				}
+			}
+		}
+
+		for (const Mover& m : movers) {
+			if (activity[m.chunk] == ChunkActivity::ACTIVE) {
+				onEnterActive(pool[m.slot]);
+				Release(m.slot);
+			}
+			else {
+				Link(m.slot, m.chunk);
+			}
+		}
+		return moved;
+	}
+
+private:
+	struct Mover {
+		uint32_t slot;
+		int chunk;
+	};
+
+	void Link(uint32_t slot, int chunk) {
+		next[slot] = head[chunk];
+		head[chunk] = slot;
+		++counts[chunk];
+	}
+
+	// Returns a slot to the free list, the caller has already unlinked it
+	void Release(uint32_t slot) {
+		next[slot] = freeHead;
+		freeHead = slot;
+		--parked;
+	}
+
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	int columns;
+	int rows;
+	float chunkSize;
+	size_t capacity;
+	int centerX = -1;
+	int centerY = -1;
+
+	std::vector<ChunkActivity> activity;
+	std::vector<double> lastTick;
+	std::vector<uint32_t> head;   // first pooled asteroid of each chunk
+	std::vector<uint32_t> counts;
+
+	std::vector<Asteroid> pool;
+	std::vector<uint32_t> next;   // next asteroid in the same chunk, or next free slot
+	uint32_t freeHead = NONE;
+	size_t parked = 0;
+	std::vector<Mover> movers;
+};
+
+// --- COLLISION EVENTS ---
+// Declaration order is resolution order: projectile hits are applied first,
+// asteroids and gunships destroyed by them can no longer hurt the ship or bounce.
+enum class CollisionType : uint8_t {
+	PROJECTILE_ASTEROID, PROJECTILE_ENEMY,   // player shots
+	ASTEROID_SHIP, ENEMY_SHIP, SHOT_SHIP,    // the player ship gets hit
+	ASTEROID_ASTEROID,
+};
+
+struct CollisionEvent {
+	CollisionType type;
+	uint32_t a; // projectile index for PROJECTILE_* and SHOT_SHIP, gunship index for ENEMY_SHIP, otherwise asteroid index
+	uint32_t b; // PROJECTILE_ASTEROID / ASTEROID_ASTEROID: asteroid index (a < b for the latter), PROJECTILE_ENEMY: gunship index, *_SHIP: unused
+	Vector2 normal{}; // ASTEROID_ASTEROID: from a to b
+	float depth = 0.f; // ASTEROID_ASTEROID: how far the outlines overlap along normal
+
+	bool operator<(const CollisionEvent& o) const {
+		if (type != o.type) return type < o.type;
+		if (a != o.a) return a < o.a;
+		return b < o.b;
+	}
+};
+
+// Removes every element whose flag is set, keeping the order of the rest
+template <typename T>
+static void EraseFlagged(std::vector<T>& items, const std::vector<uint8_t>& flags) {
+	size_t out = 0;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (flags[i]) continue;
+		if (out != i) items[out] = std::move(items[i]);
+		++out;
+	}
+	items.erase(items.begin() + out, items.end());
+}
+
+// --- SIMULATION ---
+// World size and buffer capacities. The defaults are the game's big world, the
+// batch environment uses a one-screen arena so thousands of instances fit in memory.
+struct SimConfig {
+	int chunksX = 64;
+	int chunksY = 32;
+	float chunkSize = 1024.f;
+	size_t worldAsteroids = 30'000;     // population the world is kept at
+	size_t maxAsteroids = 4000;         // active asteroids in stress mode
+	size_t maxProjectiles = 10'000;
+	size_t maxCollisionEvents = 32'768;
+	size_t maxGunships = 6;
+	float safeRadius = 900.f;           // asteroid-free around the start position
+
+	float WorldWidth() const {
+		return chunksX * chunkSize;
+	}
+
+	float WorldHeight() const {
+		return chunksY * chunkSize;
+	}
+
+	size_t ActiveCapacity() const {
+		return 2 * maxAsteroids;
+	}
+
+	// Most asteroids the world ever holds: the population plus the stress-mode extra
+	size_t PopulationLimit() const {
+		return worldAsteroids + maxAsteroids;
+	}
+
+	// Parking pool slots. Every asteroid the spawners can create fits, so parking never fails.
+	size_t ParkingCapacity() const {
+		return PopulationLimit();
+	}
+};
+
+// Complete game state and rules, advanced by Step with explicit input. Nothing
+// here touches the window, textures or input devices, so it also runs headless.
+// The world is much larger than the view and persistent; only the asteroids in
+// the ACTIVE chunks around the player are in `asteroids`, the rest are parked
+// in the ChunkGrid.
+class Simulation {
+public:
+	// viewW x viewH is what the player sees, the world size comes from the config
+	Simulation(int viewW, int viewH, uint64_t seed, const SimConfig& cfg = SimConfig{})
+		: config(cfg), worldW(cfg.WorldWidth()), worldH(cfg.WorldHeight()),
+		width(viewW), height(viewH), rng(seed), player(static_cast<int>(worldW), static_cast<int>(worldH)),
+		chunks(cfg.chunksX, cfg.chunksY, cfg.chunkSize, cfg.ParkingCapacity()),
+		scripts(cfg.ParkingCapacity() / 8)
+	{
+		asteroids.reserve(config.ActiveCapacity());
+		asteroidScratch.reserve(config.ActiveCapacity());
+		pendingAsteroids.reserve(config.ActiveCapacity());
+		projectiles.reserve(config.maxProjectiles);
+		collisionEvents.reserve(config.maxCollisionEvents);
+		narrowEvents.reserve(config.maxCollisionEvents);
+		narrowphase.Reserve(config.maxCollisionEvents);
+		poses.reserve(config.ActiveCapacity());
+		poseStamps.reserve(config.ActiveCapacity());
+		projectileHit.reserve(config.maxProjectiles);
+		asteroidHit.reserve(config.ActiveCapacity());
+		leaving.reserve(config.ActiveCapacity());
+		asteroidRemap.reserve(config.ActiveCapacity());
+		asteroidBoxes.reserve(config.ActiveCapacity());
+		broadphase.Reserve(config.ActiveCapacity());
+		spawnedIndices.reserve(config.ActiveCapacity());
+		gunships.reserve(config.maxGunships);
+		gunshipHit.reserve(config.maxGunships);
+		layers.SkipSelfPairs(LAYER_ASTEROID);
+		layers.Reserve(LAYER_PLAYER, 1);
+		layers.Reserve(LAYER_PLAYER_SHOT, config.maxProjectiles);
+		layers.Reserve(LAYER_ENEMY, config.maxGunships);
+		layers.Reserve(LAYER_ENEMY_SHOT, config.maxProjectiles);
+		layers.Reserve(LAYER_ASTEROID, config.ActiveCapacity());
+		Restart();
+	}
+
+	// Starts over from `seed` as if freshly constructed, reusing every buffer
+	void Reset(uint64_t seed) {
+		rng = Utils::Rng(seed);
+		time = 0.0;
+		tick = 0;
+		currentWeapon = WeaponType::LASER;
+		frameSpawns = 0;
+		frameCollisionTests = 0;
+		frameMaskRejected = 0;
+		Restart();
+	}
+
+	void Step(float dt, const PlayerInput& input) {
+		time += dt;
+		++tick;
+		spawnTimer += dt;
+		frameSpawns = 0;
+
+		// Update player
+		player.SetInput(input);
+		player.Update(dt);
+		player.KeepInside(worldW, worldH);
+
+		// Restart logic
+		if (!player.IsAlive() && input.restart) {
+			Restart();
+		}
+
+		// Resume the enemy scripts whose step has ended
+		{
+			PROFILE_ZONE("Update.Scripts");
+			scripts.Run(time, player.GetPosition());
+			PROFILE_COUNTER("Script resumes", static_cast<long long>(scripts.LastResumes()));
+			PROFILE_COUNTER("Scripts", static_cast<long long>(scripts.Live()));
+			PROFILE_COUNTER("Scripts parked", static_cast<long long>(scripts.Suspended()));
+		}
+
+		UpdateGunships(dt);
+
+		// Wake the chunks the player approaches and move the reduced ring.
+		// With the whole grid active there is nothing to stream.
+		if (!chunks.AllActive()) {
+			PROFILE_ZONE("Update.Chunks");
+			Vector2 playerPos = player.GetPosition();
+			EnemyBrain* brains = scripts.Brains();
+			chunks.Focus(chunks.ChunkOf(playerPos), time, [&](int chunk, ChunkActivity before) {
+				// Reduced chunks catch up on the ticks they skipped, sleeping ones resume where they stopped
+				float catchUp = (before == ChunkActivity::REDUCED) ? static_cast<float>(chunks.SinceTick(chunk, time)) : 0.f;
+				chunks.Drain(chunk, [&](Asteroid& a) {
+					if (catchUp > 0.f) a.UpdateAny(catchUp, playerPos, worldW, worldH, brains);
+					Unpark(a);
+				});
+			});
+			size_t moved = chunks.TickReduced(tick, time,
+				[&](Asteroid& a, float chunkDt) { a.UpdateAny(chunkDt, playerPos, worldW, worldH, brains); },
+				[&](const Asteroid& a) { Unpark(a); });
+			PROFILE_COUNTER("Reduced-rate asteroid updates", static_cast<long long>(moved));
+			PROFILE_COUNTER("Parked asteroids", static_cast<long long>(chunks.ParkedCount()));
+		}
+
+		// Weapon switch
+		if (input.switchWeapon) {
+			currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+		}
+
+		// Shooting
+		{
+			if (player.IsAlive() && input.fire && player.CanShoot()) {
+				shotTimer += dt;
+				float interval = 1.f / player.GetFireRate(currentWeapon);
+				float projSpeed = player.GetSpacing(currentWeapon) * player.GetFireRate(currentWeapon);
+
+				while (shotTimer >= interval) {
+					Vector2 p = player.GetPosition();
+					p.y -= player.GetRadius();
+					projectiles.push_back(MakeProjectile(currentWeapon, p, projSpeed));
+					shotTimer -= interval;
+
+					// --- OVERHEAT ---
+					player.overheat += PlayerShip::OVERHEAT_PER_SHOT;
+					player.overheatCooldown = PlayerShip::OVERHEAT_COOLDOWN_DELAY;
+					if (player.overheat >= PlayerShip::OVERHEAT_MAX) {
+						player.overheated = true;
+						player.overheat = PlayerShip::OVERHEAT_MAX;
+					}
+				}
+			}
+			else {
+				float maxInterval = 1.f / player.GetFireRate(currentWeapon);
+
+				if (shotTimer > maxInterval) {
+					shotTimer = fmodf(shotTimer, maxInterval);
+				}
+			}
+			if (player.IsAlive() && player.overheated && input.skill && !player.overheatSkillUsed) {
+				const int numBullets = 50;
+				float angleStep = 2 * PI / numBullets;
+				float bulletSpeed = 600.0f;
+				Vector2 center = player.GetPosition();
+				for (int i = 0; i < numBullets; ++i) {
+					float angle = i * angleStep;
+					Vector2 dir = { cosf(angle), sinf(angle) };
+					Vector2 pos = center;
+					Vector2 vel = Vector2Scale(dir, bulletSpeed);
+					projectiles.push_back(Projectile(pos, vel, 10, WeaponType::BULLET, true));
+				}
+				player.overheatSkillUsed = true;
+			}
+
+		}
+
+		// Spawn asteroids at the edge of the view, topping the world back up after the player's kills
+		if (spawnTimer >= spawnInterval && WorldPopulation() < config.worldAsteroids) {
+			pendingAsteroids.push_back(SpawnAsteroid(GetView()));
+			++frameSpawns;
+			spawnTimer = 0.f;
+			spawnInterval = rng.Float(C_SPAWN_MIN, C_SPAWN_MAX);
+		}
+		// Stress test - keep the active chunks filled up to config.maxAsteroids
+		if (stressMode) {
+			for (int i = 0; i < C_STRESS_SPAWN_PER_FRAME && asteroids.size() + pendingAsteroids.size() < config.maxAsteroids
+				&& WorldPopulation() < MaxAsteroids(); ++i) {
+				pendingAsteroids.push_back(SpawnAsteroid(GetView()));
+				++frameSpawns;
+			}
+		}
+
+		// Move projectiles and asteroids. Projectiles die when they leave the active
+		// chunks, asteroids that drift out of them are parked in the chunk they entered.
+		{
+			PROFILE_ZONE("Update.Move");
+			Rectangle bounds = chunks.ActiveBounds();
+			auto projectile_to_remove = std::remove_if(projectiles.begin(), projectiles.end(),
+				[dt, bounds](auto& projectile) {
+					return projectile.Update(dt, bounds);
+				});
+			projectiles.erase(projectile_to_remove, projectiles.end());
+
+			Vector2 playerPos = player.GetPosition();
+			EnemyBrain* brains = scripts.Brains();
+			maxAsteroidSpeedSq = 0.f;
+			ForEachAsteroidKind([&](auto kind) {
+				constexpr AsteroidKind K = decltype(kind)::value;
+				for (uint32_t i = KindBegin(K); i < KindEnd(K); ++i) {
+					asteroids[i].Update<K>(dt, playerPos, worldW, worldH, brains);
+					maxAsteroidSpeedSq = std::max(maxAsteroidSpeedSq, Vector2LengthSqr(asteroids[i].GetVelocity()));
+				}
+			});
+
+			// Parked together with the removals at the end of the tick, so the
+			// array is rebuilt at most once per tick
+			leaving.clear();
+			if (!chunks.AllActive()) {
+				for (uint32_t i = 0; i < asteroids.size(); ++i) {
+					if (chunks.Activity(chunks.ChunkOf(asteroids[i].GetPosition())) != ChunkActivity::ACTIVE) leaving.push_back(i);
+				}
+			}
+		}
+
+		// Collisions - detect into an ordered event list, then resolve it in one pass
+		{
+			PROFILE_ZONE("Collide.Detect");
+			collisionEvents.clear();
+			narrowEvents.clear();
+			narrowphase.Clear();
+			poses.resize(asteroids.size());
+			poseStamps.resize(asteroids.size());
+			frameCollisionTests = 0;
+			// Asteroid pairs first: their sweep leaves the asteroid order sorted for the layers
+			DetectAsteroidPairs();
+			DetectCollisions(collisionEvents);
+			RunNarrowphase(collisionEvents);
+			std::sort(collisionEvents.begin(), collisionEvents.end());
+		}
+		ResolveCollisions();
+	}
+
+	void SetSpawnShape(AsteroidShape shape) {
+		currentShape = shape;
+	}
+
+	void SetStressMode(bool on) {
+		stressMode = on;
+	}
+
+	bool IsStressMode() const {
+		return stressMode;
+	}
+
+	void SetBruteForceBroadphase(bool on) {
+		bruteForceBroadphase = on;
+	}
+
+	bool IsBruteForceBroadphase() const {
+		return bruteForceBroadphase;
+	}
+
+	const PlayerShip& GetPlayer() const {
+		return player;
+	}
+
+	const std::vector<Asteroid>& GetAsteroids() const {
+		return asteroids;
+	}
+
+	// Fills `out` with the indices into GetAsteroids() of every active asteroid
+	// whose circle touches `box`, and of some near it: the candidates are the
+	// asteroids whose box at the last sweep, grown by how far bounces moved
+	// asteroids after it, overlaps `box`, plus those that became active since.
+	// Returns false instead when most asteroids are candidates anyway; callers
+	// then walk GetAsteroids() whole. Either way they test what they get. `out`
+	// needs room for SimConfig::ActiveCapacity() indices to stay allocation-free.
+	bool CollectAsteroidsNear(Rectangle box, std::vector<uint32_t>& out) const {
+		if (bruteForceBroadphase) {
+			out.clear();
+			return false;
+		}
+		Aabb grown = { box.x - bounceDrift, box.y - bounceDrift, box.x + box.width + bounceDrift, box.y + box.height + bounceDrift };
+		return broadphase.CollectOverlapping(grown, out);
+	}
+
+	// Fastest active asteroid as of the end of the last tick
+	float MaxAsteroidSpeed() const {
+		return sqrtf(maxAsteroidSpeedSq);
+	}
+
+	const std::vector<Projectile>& GetProjectiles() const {
+		return projectiles;
+	}
+
+	const std::vector<EnemyShip>& GetGunships() const {
+		return gunships;
+	}
+
+	uint32_t KindBegin(AsteroidKind kind) const {
+		return kindStart[static_cast<size_t>(kind)];
+	}
+
+	uint32_t KindEnd(AsteroidKind kind) const {
+		return kindStart[static_cast<size_t>(kind) + 1];
+	}
+
+	WeaponType GetWeapon() const {
+		return currentWeapon;
+	}
+
+	int GetScore() const {
+		return score;
+	}
+
+	double GetTime() const {
+		return time;
+	}
+
+	int Width() const {
+		return width;
+	}
+
+	int Height() const {
+		return height;
+	}
+
+	float WorldWidth() const {
+		return worldW;
+	}
+
+	float WorldHeight() const {
+		return worldH;
+	}
+
+	// The view-sized box centered on the player, clamped to the world
+	Rectangle GetView() const {
+		Vector2 p = player.GetPosition();
+		float x = Clamp(p.x - width * 0.5f, 0.f, worldW - width);
+		float y = Clamp(p.y - height * 0.5f, 0.f, worldH - height);
+		return { x, y, (float)width, (float)height };
+	}
+
+	const SimConfig& GetConfig() const {
+		return config;
+	}
+
+	const ChunkGrid& GetChunks() const {
+		return chunks;
+	}
+
+	// Every asteroid in the world, active or parked
+	size_t WorldPopulation() const {
+		return asteroids.size() + pendingAsteroids.size() + chunks.ParkedCount();
+	}
+
+	size_t MaxAsteroids() const {
+		return stressMode ? config.PopulationLimit() : config.worldAsteroids;
+	}
+
+	// Asteroids that found the parking pool full. The pool holds the whole
+	// population, so anything but 0 is a bug; the run reports it as an error.
+	uint64_t GetParkingFailures() const {
+		return parkingFailures;
+	}
+
+	uint64_t GetFrameSpawns() const {
+		return frameSpawns;
+	}
+
+	uint64_t GetFrameCollisionTests() const {
+		return frameCollisionTests;
+	}
+
+	uint64_t GetFrameMaskRejected() const {
+		return frameMaskRejected;
+	}
+
+private:
+	// Scatters the world population over the map, keeping the player's surroundings clear.
+	// Everything starts parked, the first Step wakes the chunks around the player.
+	void Populate() {
+		chunks.Clear();
+		scripts.Clear();
+		Vector2 start = player.GetPosition();
+		Rectangle view = GetView();
+		for (size_t i = 0; i < config.worldAsteroids; ++i) {
+			Vector2 pos;
+			do {
+				pos = { rng.Float(0, worldW), rng.Float(0, worldH) };
+			} while (Vector2Distance(pos, start) < config.safeRadius);
+			Asteroid a = MakeAsteroid(rng, view, currentShape);
+			a.Place(rng, pos);
+			AttachScript(a);
+			if (!Park(a)) pendingAsteroids.push_back(a);
+		}
+	}
+
+	// Parked asteroids keep their script slot, but the script sleeps until they
+	// are active again; meanwhile they follow the brain's last steering.
+	// A full pool counts as a parking failure and the asteroid stays active.
+	bool Park(const Asteroid& a) {
+		if (!chunks.Park(a)) {
+			++parkingFailures;
+			return false;
+		}
+		if (a.GetScript() != ScriptScheduler::NONE) scripts.Suspend(a.GetScript());
+		return true;
+	}
+
+	void Unpark(const Asteroid& a) {
+		if (a.GetScript() != ScriptScheduler::NONE) scripts.Wake(a.GetScript());
+		pendingAsteroids.push_back(a);
+	}
+
+	Asteroid SpawnAsteroid(Rectangle view) {
+		Asteroid a = MakeAsteroid(rng, view, currentShape);
+		AttachScript(a);
+		return a;
+	}
+
+	// Gunships follow their scripts and fire the volleys the scripts ask for.
+	// New ones arrive from just outside the view while there is room.
+	void UpdateGunships(float dt) {
+		PROFILE_ZONE("Update.Gunships");
+		gunshipTimer += dt;
+		if (player.IsAlive() && gunshipTimer >= gunshipInterval && gunships.size() < config.maxGunships) {
+			gunshipTimer = 0.f;
+			gunshipInterval = rng.Float(C_GUNSHIP_MIN, C_GUNSHIP_MAX);
+			float ang = rng.Float(0.f, 2.f * PI);
+			float dist = Vector2Length({ (float)width, (float)height }) * 0.5f + 100.f;
+			Vector2 pos = Vector2Add(player.GetPosition(), { cosf(ang) * dist, sinf(ang) * dist });
+			pos = { Clamp(pos.x, 0.f, worldW), Clamp(pos.y, 0.f, worldH) };
+			uint32_t brain = scripts.Spawn(GunshipScript, rng.Next(), pos, EnemyShip::SPEED);
+			gunships.emplace_back(pos, brain);
+		}
+
+		Vector2 playerPos = player.GetPosition();
+		for (EnemyShip& g : gunships) {
+			EnemyBrain& brain = scripts.Brain(g.GetScript());
+			g.Follow(brain, playerPos, dt);
+			g.Update(dt);
+			g.KeepInside(worldW, worldH);
+			brain.position = g.GetPosition();
+
+			if (brain.volley > 0) {
+				float aim = atan2f(playerPos.y - brain.position.y, playerPos.x - brain.position.x);
+				for (int i = 0; i < brain.volley; ++i) {
+					float t = (brain.volley > 1) ? static_cast<float>(i) / (brain.volley - 1) - 0.5f : 0.f;
+					float a = aim + t * brain.spread;
+					Vector2 vel = { cosf(a) * EnemyShip::SHOT_SPEED, sinf(a) * EnemyShip::SHOT_SPEED };
+					projectiles.push_back(MakeEnemyShot(brain.position, vel));
+				}
+				brain.volley = 0;
+			}
+		}
+	}
+
+	// Starts the kind's behavior script once the asteroid is in place
+	void AttachScript(Asteroid& a) {
+		const AsteroidTraits& traits = ASTEROID_TRAITS[static_cast<size_t>(a.GetKind())];
+		if (!traits.script) return;
+		a.SetScript(scripts.Spawn(traits.script, rng.Next(), a.GetPosition(), traits.scriptSpeed));
+	}
+
+	void Restart() {
+		player = PlayerShip(static_cast<int>(worldW), static_cast<int>(worldH));
+		gunships.clear();
+		gunshipTimer = 0.f;
+		asteroids.clear();
+		pendingAsteroids.clear();
+		kindStart.fill(0);
+		broadphase.Clear();
+		bounceDrift = 0.f;
+		maxAsteroidSpeedSq = 0.f;
+		poseStamps.clear(); // Reset rewinds the tick, old stamps could match again
+		projectiles.clear();
+		spawnTimer = 0.f;
+		spawnInterval = rng.Float(C_SPAWN_MIN, C_SPAWN_MAX);
+		gunshipInterval = rng.Float(C_GUNSHIP_MIN, C_GUNSHIP_MAX);
+		shotTimer = 0.f;
+		score = 0; // <-- DODAJ TO
+		Populate();
+	}
+
+	// Pure detection - reads entity state only and appends every overlapping pair.
+	// Nothing is removed here, so the result does not depend on iteration order.
+	// Everything but asteroid pairs goes through the layered broadphase; pairs
+	// with an asteroid wait for the narrowphase to check its outline.
+	void DetectCollisions(std::vector<CollisionEvent>& out) {
+		layers.Clear();
+		if (player.IsAlive()) layers.Add(player.GetFilter(), player.GetPosition(), player.GetRadius(), 0);
+		for (uint32_t p = 0; p < projectiles.size(); ++p) {
+			layers.Add(projectiles[p].GetFilter(), projectiles[p].GetPosition(), projectiles[p].GetRadius(), p);
+		}
+		for (uint32_t g = 0; g < gunships.size(); ++g) {
+			layers.Add(gunships[g].GetFilter(), gunships[g].GetPosition(), gunships[g].GetRadius(), g);
+		}
+		// Added in the sweep-and-prune order, which the sweep just sorted by the same
+		// left edges, so the layer query does not sort the asteroids again
+		for (uint32_t a : broadphase.GetOrder()) {
+			layers.Add(asteroids[a].GetFilter(), asteroids[a].GetPosition(), asteroids[a].GetRadius(), a);
+		}
+		if (!bruteForceBroadphase) layers.MarkSorted(LAYER_ASTEROID);
+
+		layers.Query([this, &out](uint8_t la, uint32_t a, uint8_t lb, uint32_t b) {
+			switch (la | lb) {
+			case LAYER_PLAYER_SHOT | LAYER_ASTEROID:
+				QueueCircle(b, projectiles[a].GetPosition(), projectiles[a].GetRadius(), { CollisionType::PROJECTILE_ASTEROID, a, b });
+				break;
+			case LAYER_PLAYER_SHOT | LAYER_ENEMY:    out.push_back({ CollisionType::PROJECTILE_ENEMY, a, b }); break;
+			case LAYER_PLAYER | LAYER_ASTEROID:
+				QueueCircle(b, player.GetPosition(), player.GetRadius(), { CollisionType::ASTEROID_SHIP, b, 0 });
+				break;
+			case LAYER_PLAYER | LAYER_ENEMY:         out.push_back({ CollisionType::ENEMY_SHIP, b, 0 }); break;
+			case LAYER_PLAYER | LAYER_ENEMY_SHOT:    out.push_back({ CollisionType::SHOT_SHIP, b, 0 }); break;
+			default: break;
+			}
+		});
+
+		const LayeredBroadphase::Stats& st = layers.GetStats();
+		PROFILE_COUNTER("Layer candidates", st.candidates);
+		PROFILE_COUNTER("Mask-rejected pairs", st.maskRejected);
+		frameCollisionTests += static_cast<uint64_t>(st.candidates);
+		frameMaskRejected = static_cast<uint64_t>(st.maskRejected);
+	}
+
+	// Asteroid pairs go through sweep-and-prune, or all-pairs when comparing the two (F3).
+	// Overlapping circles are the cheap early-out, the outlines are checked later.
+	void DetectAsteroidPairs() {
+		size_t before = narrowEvents.size();
+		auto narrow = [this](uint32_t a, uint32_t b) {
+			float dist = Vector2Distance(asteroids[a].GetPosition(), asteroids[b].GetPosition());
+			if (dist < asteroids[a].GetRadius() + asteroids[b].GetRadius()) {
+				narrowEvents.push_back({ CollisionType::ASTEROID_ASTEROID, a, b });
+				narrowphase.AddHulls(asteroids[a].GetKind(), PoseOf(a), asteroids[b].GetKind(), PoseOf(b),
+					static_cast<uint32_t>(narrowEvents.size() - 1));
+			}
+		};
+
+		if (bruteForceBroadphase) {
+			PROFILE_ZONE("Broadphase.AllPairs");
+			for (uint32_t a = 0; a < asteroids.size(); ++a)
+				for (uint32_t b = a + 1; b < asteroids.size(); ++b)
+					narrow(a, b);
+			long long n = static_cast<long long>(asteroids.size());
+			PROFILE_COUNTER("Broadphase candidates", n * (n - 1) / 2);
+			frameCollisionTests += static_cast<uint64_t>(n * (n - 1) / 2);
+		}
+		else {
+			PROFILE_ZONE("Broadphase.SweepAndPrune");
+			asteroidBoxes.resize(asteroids.size());
+			for (size_t i = 0; i < asteroids.size(); ++i) {
+				Vector2 p = asteroids[i].GetPosition();
+				float r = asteroids[i].GetRadius();
+				asteroidBoxes[i] = { p.x - r, p.y - r, p.x + r, p.y + r };
+			}
+			broadphase.Sweep(asteroidBoxes, narrow);
+			bounceDrift = 0.f;
+
+			const SweepAndPrune::Stats& st = broadphase.GetStats();
+			PROFILE_COUNTER("Broadphase candidates", st.candidates);
+			PROFILE_COUNTER("Broadphase box overlaps", st.overlaps);
+			PROFILE_COUNTER("Broadphase sort swaps", st.swaps);
+			frameCollisionTests += static_cast<uint64_t>(st.overlaps);
+		}
+		PROFILE_COUNTER("Asteroid circle contacts", static_cast<long long>(narrowEvents.size() - before));
+		PROFILE_COUNTER("Asteroids", static_cast<long long>(asteroids.size()));
+	}
+
+	// A circle (shot or ship) whose circle overlaps asteroid `a`, for the narrowphase
+	void QueueCircle(uint32_t a, Vector2 center, float radius, const CollisionEvent& event) {
+		narrowEvents.push_back(event);
+		narrowphase.AddCircle(asteroids[a].GetKind(), PoseOf(a), center, radius, static_cast<uint32_t>(narrowEvents.size() - 1));
+	}
+
+	// Sprite pose of asteroid i, worked out once per tick on first use
+	const ShapePose& PoseOf(uint32_t i) {
+		if (poseStamps[i] != tick + 1) {
+			poses[i] = asteroids[i].GetPose(player.GetPosition());
+			poseStamps[i] = tick + 1;
+		}
+		return poses[i];
+	}
+
+	// Keeps the queued events whose shapes really touch
+	void RunNarrowphase(std::vector<CollisionEvent>& out) {
+		PROFILE_ZONE("Collide.Narrowphase");
+		narrowphase.Run([this, &out](uint32_t tag, const Narrowphase::Contact& contact) {
+			CollisionEvent e = narrowEvents[tag];
+			e.normal = contact.normal;
+			e.depth = contact.depth;
+			out.push_back(e);
+		});
+		const Narrowphase::Stats& st = narrowphase.GetStats();
+		PROFILE_COUNTER("Narrowphase circle pairs", st.circlePairs);
+		PROFILE_COUNTER("Narrowphase hull pairs", st.hullPairs);
+		PROFILE_COUNTER("Narrowphase rejected", st.rejected);
+	}
+
+	// Drops flagged asteroids and merges pending spawns, regrouping the array by
+	// kind so every kind updates and draws as one contiguous batch. Every change
+	// to `asteroids` goes through here, once at the end of a tick, to keep the
+	// broadphase order in sync; a tick that changed nothing leaves both alone.
+	void CompactAsteroids(const std::vector<uint8_t>& flags) {
+		if (pendingAsteroids.empty() && std::find(flags.begin(), flags.end(), uint8_t{ 1 }) == flags.end()) return;
+		asteroidRemap.assign(asteroids.size(), UINT32_MAX);
+		asteroidScratch.clear();
+
+		// The array is already grouped, each kind only walks its own range
+		std::array<uint32_t, ASTEROID_KIND_COUNT + 1> before = kindStart;
+		for (size_t k = 0; k < ASTEROID_KIND_COUNT; ++k) {
+			AsteroidKind kind = static_cast<AsteroidKind>(k);
+			kindStart[k] = static_cast<uint32_t>(asteroidScratch.size());
+			for (uint32_t i = before[k]; i < before[k + 1]; ++i) {
+				if (flags[i]) continue;
+				asteroidRemap[i] = static_cast<uint32_t>(asteroidScratch.size());
+				asteroidScratch.push_back(asteroids[i]);
+			}
+			for (const Asteroid& a : pendingAsteroids) {
+				if (a.GetKind() != kind) continue;
+				spawnedIndices.push_back(static_cast<uint32_t>(asteroidScratch.size()));
+				asteroidScratch.push_back(a);
+				maxAsteroidSpeedSq = std::max(maxAsteroidSpeedSq, Vector2LengthSqr(a.GetVelocity()));
+			}
+		}
+		kindStart[ASTEROID_KIND_COUNT] = static_cast<uint32_t>(asteroidScratch.size());
+
+		asteroids.swap(asteroidScratch);
+		pendingAsteroids.clear();
+
+		broadphase.Remap(asteroidRemap);
+		for (uint32_t idx : spawnedIndices) broadphase.Insert(idx);
+		spawnedIndices.clear();
+	}
+
+	// Walks the sorted event list once. An entity consumed by an earlier event
+	// is skipped by later ones, removal happens after the whole list is applied.
+	void ResolveCollisions() {
+		projectileHit.assign(projectiles.size(), 0);
+		asteroidHit.assign(asteroids.size(), 0);
+		gunshipHit.assign(gunships.size(), 0);
+
+		auto first = collisionEvents.begin();
+		auto split = std::partition_point(first, collisionEvents.end(),
+			[](const CollisionEvent& e) { return e.type < CollisionType::ASTEROID_SHIP; });
+		auto bounces = std::partition_point(split, collisionEvents.end(),
+			[](const CollisionEvent& e) { return e.type < CollisionType::ASTEROID_ASTEROID; });
+
+		{
+			PROFILE_ZONE("Resolve.Projectile");
+			for (auto it = first; it != split; ++it) {
+				if (projectileHit[it->a]) continue;
+				if (it->type == CollisionType::PROJECTILE_ASTEROID) {
+					if (asteroidHit[it->b]) continue;
+					projectileHit[it->a] = 1;
+					asteroidHit[it->b] = 1;
+					score += 10 * asteroids[it->b].GetSize(); // 10 punktów za SMALL, 20 za MEDIUM, 40 za LARGE
+				}
+				else {
+					if (gunshipHit[it->b]) continue;
+					projectileHit[it->a] = 1;
+					gunships[it->b].TakeDamage(projectiles[it->a].GetDamage());
+					if (!gunships[it->b].IsAlive()) {
+						gunshipHit[it->b] = 1;
+						score += EnemyShip::SCORE;
+					}
+				}
+			}
+		}
+		{
+			PROFILE_ZONE("Resolve.Ship");
+			for (auto it = split; it != bounces; ++it) {
+				if (!player.IsAlive()) break;
+				switch (it->type) {
+				case CollisionType::ASTEROID_SHIP:
+					if (asteroidHit[it->a]) continue;
+					asteroidHit[it->a] = 1;
+					player.TakeDamage(asteroids[it->a].GetDamage());
+					break;
+				case CollisionType::ENEMY_SHIP:
+					if (gunshipHit[it->a]) continue;
+					gunshipHit[it->a] = 1;
+					player.TakeDamage(EnemyShip::RAM_DAMAGE);
+					break;
+				default:
+					if (projectileHit[it->a]) continue;
+					projectileHit[it->a] = 1;
+					player.TakeDamage(projectiles[it->a].GetDamage());
+					break;
+				}
+			}
+		}
+		{
+			PROFILE_ZONE("Resolve.AsteroidAsteroid");
+			for (auto it = bounces; it != collisionEvents.end(); ++it) {
+				if (asteroidHit[it->a] || asteroidHit[it->b]) continue;
+				Asteroid::Bounce(asteroids[it->a], asteroids[it->b], it->normal, it->depth);
+				// No asteroid moves farther than all the overlaps together, which bounds the drift since the sweep
+				bounceDrift += it->depth;
+				maxAsteroidSpeedSq = std::max({ maxAsteroidSpeedSq,
+					Vector2LengthSqr(asteroids[it->a].GetVelocity()), Vector2LengthSqr(asteroids[it->b].GetVelocity()) });
+			}
+		}
+		{
+			PROFILE_ZONE("Resolve.Remove");
+			for (size_t i = 0; i < asteroids.size(); ++i) {
+				if (asteroidHit[i] && asteroids[i].GetScript() != ScriptScheduler::NONE) scripts.Kill(asteroids[i].GetScript());
+			}
+			// Out of the active chunks and not destroyed: into the parking pool
+			for (uint32_t i : leaving) {
+				if (asteroidHit[i]) continue;
+				if (Park(asteroids[i])) asteroidHit[i] = 1;
+			}
+			for (size_t i = 0; i < gunships.size(); ++i) {
+				if (gunshipHit[i]) scripts.Kill(gunships[i].GetScript());
+			}
+			EraseFlagged(gunships, gunshipHit);
+			EraseFlagged(projectiles, projectileHit);
+			CompactAsteroids(asteroidHit);
+		}
+	}
+
+	SimConfig config;
+	float worldW;
+	float worldH;
+	int width;
+	int height;
+	Utils::Rng rng;
+	double time = 0.0;
+	uint64_t tick = 0;
+
+	PlayerShip player;
+	ChunkGrid chunks;
+	ScriptScheduler scripts;
+	std::vector<EnemyShip> gunships;
+	std::vector<uint8_t> gunshipHit;
+	float gunshipTimer = 0.f;
+	float gunshipInterval = 0.f;
+	LayeredBroadphase layers;
+	WeaponType currentWeapon = WeaponType::LASER;
+	float shotTimer = 0.f;
+	float spawnTimer = 0.f;
+	float spawnInterval = 0.f;
+	int score = 0;
+
+	std::vector<Asteroid> asteroids; // grouped by kind, see KindBegin/KindEnd
+	std::vector<Asteroid> pendingAsteroids;
+	std::vector<Projectile> projectiles;
+
+	std::vector<CollisionEvent> collisionEvents;
+	std::vector<CollisionEvent> narrowEvents; // waiting for the narrowphase, indexed by its tags
+	Narrowphase narrowphase;
+	std::vector<ShapePose> poses;             // by asteroid index, valid where poseStamps is tick + 1
+	std::vector<uint64_t> poseStamps;
+	std::vector<uint8_t> projectileHit;
+	std::vector<uint8_t> asteroidHit;
+	std::vector<uint32_t> leaving;            // asteroids outside the active chunks this tick
+	uint64_t frameSpawns = 0;
+	uint64_t frameCollisionTests = 0;
+	uint64_t frameMaskRejected = 0;
+	uint64_t parkingFailures = 0; // over the simulation's lifetime, Reset keeps it
+
+	std::array<uint32_t, ASTEROID_KIND_COUNT + 1> kindStart{};
+	std::vector<Asteroid> asteroidScratch;
+	std::vector<uint32_t> asteroidRemap;
+	std::vector<uint32_t> spawnedIndices;
+
+	SweepAndPrune broadphase;
+	std::vector<Aabb> asteroidBoxes;
+	float bounceDrift = 0.f;        // how far bounces may have moved an asteroid since the last sweep
+	float maxAsteroidSpeedSq = 0.f;
+	bool bruteForceBroadphase = false;
+	bool stressMode = false;
+
+	AsteroidShape currentShape = AsteroidShape::RANDOM;
+
+	static constexpr float C_SPAWN_MIN = 0.15f;
+	static constexpr float C_SPAWN_MAX = 0.5f;
+	static constexpr int C_STRESS_SPAWN_PER_FRAME = 40;
+	static constexpr float C_GUNSHIP_MIN = 6.f;  // seconds between gunship arrivals
+	static constexpr float C_GUNSHIP_MAX = 12.f;
+};
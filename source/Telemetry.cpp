@@ -0,0 +1,108 @@
+#include "Telemetry.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+static constexpr SocketHandle BAD_SOCKET = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketHandle = int;
+static constexpr SocketHandle BAD_SOCKET = -1;
+#endif
+
+static void CloseSocket(SocketHandle s) {
+#if defined(_WIN32)
+	closesocket(s);
+	WSACleanup();
+#else
+	close(s);
+#endif
+}
+
+static sockaddr_in LocalAddress() {
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(TELEMETRY_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return addr;
+}
+
+TelemetrySocket::~TelemetrySocket() {
+	Close();
+}
+
+bool TelemetrySocket::OpenSender() {
+	return Open(false);
+}
+
+bool TelemetrySocket::OpenReceiver() {
+	return Open(true);
+}
+
+bool TelemetrySocket::Open(bool bindLocal) {
+	Close();
+#if defined(_WIN32)
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+	SocketHandle s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == BAD_SOCKET) {
+#if defined(_WIN32)
+		WSACleanup();
+#endif
+		return false;
+	}
+
+#if defined(_WIN32)
+	u_long nonBlocking = 1;
+	ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	if (bindLocal) {
+		sockaddr_in addr = LocalAddress();
+		if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+			CloseSocket(s);
+			return false;
+		}
+	}
+
+	handle = static_cast<intptr_t>(s);
+	return true;
+}
+
+void TelemetrySocket::Close() {
+	if (handle == INVALID) return;
+	CloseSocket(static_cast<SocketHandle>(handle));
+	handle = INVALID;
+}
+
+bool TelemetrySocket::Send(const void* data, size_t size) {
+	if (handle == INVALID) return false;
+	sockaddr_in addr = LocalAddress();
+	auto sent = sendto(static_cast<SocketHandle>(handle), static_cast<const char*>(data), static_cast<int>(size), 0,
+		reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+	return sent == static_cast<decltype(sent)>(size);
+}
+
+int TelemetrySocket::Receive(void* data, size_t size, int timeoutMs) {
+	if (handle == INVALID) return -1;
+#if defined(_WIN32)
+	WSAPOLLFD pfd{ static_cast<SocketHandle>(handle), POLLRDNORM, 0 };
+	if (WSAPoll(&pfd, 1, timeoutMs) <= 0) return -1;
+#else
+	pollfd pfd{ static_cast<SocketHandle>(handle), POLLIN, 0 };
+	if (poll(&pfd, 1, timeoutMs) <= 0) return -1;
+#endif
+	auto got = recv(static_cast<SocketHandle>(handle), static_cast<char*>(data), static_cast<int>(size), 0);
+	return got < 0 ? -1 : static_cast<int>(got);
+}
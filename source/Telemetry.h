@@ -0,0 +1,82 @@
+#pragma once
+// Telemetry wire format and a minimal local UDP transport.
+// Kept free of raylib so it can share a translation unit with winsock.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+constexpr uint16_t TELEMETRY_PORT = 47800;
+constexpr uint32_t TELEMETRY_MAGIC = 0x54534154; // "TAST"
+constexpr uint32_t TELEMETRY_VERSION = 3;
+constexpr int TELEMETRY_MAX_PHASES = 16;
+constexpr int TELEMETRY_PHASE_NAME = 28;
+
+struct TelemetryPhase {
+	char  name[TELEMETRY_PHASE_NAME];
+	float avgMs; // average per simulation tick over the sample window
+};
+
+// One sample covers roughly one second of simulation ticks. Totals are over the
+// whole window: divide `drawCalls` by `frames`, the rest by `ticks` for
+// per-frame and per-tick values. Frames are those the window presented, none
+// for a headless run; the simulation ticks at its fixed rate on its own thread.
+struct TelemetryPacket {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sequence;
+	uint32_t frames;
+	float    windowSec;
+	float    fps;
+	float    avgFrameMs;
+	float    maxFrameMs;
+
+	uint32_t ticks;
+	float    tickRate;   // ticks per second
+	float    avgTickMs;  // time spent in a tick, not the interval between ticks
+	float    maxTickMs;
+
+	uint32_t asteroids;
+	uint32_t maxAsteroids;
+	uint32_t projectiles;
+	uint32_t maxProjectiles;
+
+	uint64_t spawns;
+	uint64_t collisionTests;
+	uint64_t maskRejected;   // pairs skipped by collision layer masks
+	uint64_t drawCalls;
+	uint64_t heapAllocs;
+	uint64_t heapBytes;
+
+	uint32_t phaseCount;
+	TelemetryPhase phases[TELEMETRY_MAX_PHASES];
+};
+static_assert(std::is_trivially_copyable_v<TelemetryPacket>, "TelemetryPacket is sent as raw bytes");
+
+// Non-blocking datagram socket on 127.0.0.1:TELEMETRY_PORT.
+// Sending never waits: if the datagram cannot go out right away it is dropped.
+class TelemetrySocket {
+public:
+	TelemetrySocket() = default;
+	~TelemetrySocket();
+	TelemetrySocket(const TelemetrySocket&) = delete;
+	TelemetrySocket& operator=(const TelemetrySocket&) = delete;
+
+	bool OpenSender();
+	bool OpenReceiver();
+	void Close();
+
+	bool IsOpen() const {
+		return handle != INVALID;
+	}
+
+	bool Send(const void* data, size_t size);
+	// Waits up to timeoutMs, returns the datagram size or -1 on timeout/error
+	int Receive(void* data, size_t size, int timeoutMs);
+
+private:
+	static constexpr intptr_t INVALID = -1;
+	bool Open(bool bindLocal);
+
+	intptr_t handle = INVALID;
+};
@@ -0,0 +1,60 @@
+// Prints telemetry published by a running game on this machine.
+// Start it before or after the game, samples arrive about once per second.
+
+#include <cstdio>
+
+#include "Telemetry.h"
+
+static double PerCount(uint64_t total, uint32_t count) {
+	return count ? static_cast<double>(total) / count : 0.0;
+}
+
+int main() {
+	TelemetrySocket sock;
+	if (!sock.OpenReceiver()) {
+		std::fprintf(stderr, "could not bind 127.0.0.1:%u - is another reader running?\n", TELEMETRY_PORT);
+		return 1;
+	}
+	std::printf("listening on 127.0.0.1:%u\n", TELEMETRY_PORT);
+
+	uint32_t lastSequence = 0;
+	bool haveSequence = false;
+	for (;;) {
+		TelemetryPacket p{};
+		int got = sock.Receive(&p, sizeof(p), 2000);
+		if (got < 0) {
+			std::printf("waiting for game...\n");
+			continue;
+		}
+		if (got != static_cast<int>(sizeof(p)) || p.magic != TELEMETRY_MAGIC || p.version != TELEMETRY_VERSION) {
+			std::printf("ignoring unknown datagram (%d bytes)\n", got);
+			continue;
+		}
+		if (haveSequence && p.sequence <= lastSequence) {
+			std::printf("-- game restarted\n");
+		}
+		else if (haveSequence && p.sequence != lastSequence + 1) {
+			std::printf("-- missed %u sample(s)\n", p.sequence - lastSequence - 1);
+		}
+		lastSequence = p.sequence;
+		haveSequence = true;
+
+		std::printf("\n#%u  %.1f fps  frame avg %.3f ms  max %.3f ms  (%u frames / %.2f s)\n",
+			p.sequence, p.fps, p.avgFrameMs, p.maxFrameMs, p.frames, p.windowSec);
+		std::printf("  simulation %.1f ticks/s  tick avg %.3f ms  max %.3f ms  (%u ticks)\n",
+			p.tickRate, p.avgTickMs, p.maxTickMs, p.ticks);
+		std::printf("  asteroids   %5u / %u\n", p.asteroids, p.maxAsteroids);
+		std::printf("  projectiles %5u / %u\n", p.projectiles, p.maxProjectiles);
+		std::printf("  spawns/s %.1f  collision tests/tick %.0f  draw calls/frame %.0f\n",
+			p.windowSec > 0.f ? p.spawns / p.windowSec : 0.f,
+			PerCount(p.collisionTests, p.ticks), PerCount(p.drawCalls, p.frames));
+		std::printf("  mask-rejected pairs/tick %.0f\n", PerCount(p.maskRejected, p.ticks));
+		std::printf("  heap allocs/tick %.1f  bytes/tick %.0f\n",
+			PerCount(p.heapAllocs, p.ticks), PerCount(p.heapBytes, p.ticks));
+		std::printf("  simulation phases per tick:\n");
+		for (uint32_t i = 0; i < p.phaseCount && i < TELEMETRY_MAX_PHASES; ++i) {
+			std::printf("    %-26.*s %8.3f ms\n", TELEMETRY_PHASE_NAME, p.phases[i].name, p.phases[i].avgMs);
+		}
+		std::fflush(stdout);
+	}
+}
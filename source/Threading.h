@@ -0,0 +1,95 @@
+#pragma once
+// Lock-free channels between exactly two threads: a triple buffer for "latest
+// value wins" state and a bounded queue for messages that must all arrive.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Keeps the index words of the two sides on separate cache lines
+inline constexpr size_t C_CACHE_LINE = 64;
+
+// --- TRIPLE BUFFER ---
+// One writer, one reader. The writer fills Back() and publishes it, the reader
+// takes the newest published value with Acquire() and reads Front(). Three slots
+// mean neither side ever waits or copies: the writer always has a slot the
+// reader does not hold, and a value the reader missed is simply overwritten.
+template <typename T>
+class TripleBuffer {
+public:
+	// Writer: the slot to fill next
+	T& Back() {
+		return slots[back];
+	}
+
+	// Writer: makes Back() the newest value and hands out a free slot as the new Back()
+	void Publish() {
+		uint8_t previous = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel);
+		back = previous & INDEX;
+	}
+
+	// Reader: switches Front() to the newest value, false when nothing was published since the last call
+	bool Acquire() {
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+		uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+		front = previous & INDEX;
+		return true;
+	}
+
+	// Reader: stays valid and unchanged until the next Acquire
+	const T& Front() const {
+		return slots[front];
+	}
+
+private:
+	static constexpr uint8_t INDEX = 3;
+	static constexpr uint8_t FRESH = 4; // set by Publish, cleared by Acquire
+
+	std::array<T, 3> slots;
+	alignas(C_CACHE_LINE) uint8_t back = 0;        // writer only
+	alignas(C_CACHE_LINE) std::atomic<uint8_t> middle{ 1 };
+	alignas(C_CACHE_LINE) uint8_t front = 2;       // reader only
+};
+
+// --- SPSC QUEUE ---
+// Bounded ring of N (a power of two) items for one producer and one consumer.
+// Push fails instead of blocking when the ring is full. Each side keeps a copy
+// of the other's index and rereads the shared one only when the copy says full
+// or empty, so a steady stream of messages rarely touches the other cache line.
+template <typename T, size_t N>
+class SpscQueue {
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+	// Producer
+	bool Push(const T& item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h - tailCache == N) {
+			tailCache = tail.load(std::memory_order_acquire);
+			if (h - tailCache == N) return false;
+		}
+		items[h & (N - 1)] = item;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer
+	bool Pop(T& out) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t == headCache) {
+			headCache = head.load(std::memory_order_acquire);
+			if (t == headCache) return false;
+		}
+		out = items[t & (N - 1)];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::array<T, N> items{};
+	alignas(C_CACHE_LINE) std::atomic<size_t> head{ 0 }; // next slot to write
+	size_t tailCache = 0;                                // producer's copy of tail
+	alignas(C_CACHE_LINE) std::atomic<size_t> tail{ 0 }; // next slot to read
+	size_t headCache = 0;                                // consumer's copy of head
+};